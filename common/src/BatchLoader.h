@@ -0,0 +1,114 @@
+/*
+ *  Copyright 2016 Utkin Dmitry <loentar@gmail.com>
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ *  This file is part of ngrest-db: http://github.com/loentar/ngrest-db
+ */
+
+#ifndef NGREST_BATCHLOADER_H
+#define NGREST_BATCHLOADER_H
+
+#include <functional>
+#include <list>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "Table.h"
+
+namespace ngrest {
+
+//! collects point lookups by key and loads them with one "WHERE key IN (...)" query
+//! not thread safe: use one loader per thread or per request
+template <typename DataType, typename Key>
+class BatchLoader
+{
+public:
+    //! called with the loaded item or nullptr if there is no item with the key
+    typedef std::function<void(const DataType* item)> Callback;
+
+    //! keyMember and keyField must refer to the same field, e.g.: &User::id, "id"
+    BatchLoader(Table<DataType>& table_, Key DataType::* keyMember_, const std::string& keyField_,
+                std::size_t maxBatchSize_ = 500):
+        table(table_),
+        keyMember(keyMember_),
+        keyField(keyField_),
+        maxBatchSize(maxBatchSize_)
+    {
+    }
+
+    //! schedule loading of item with the key
+    //! callbacks are called from dispatch() which is called automatically
+    //! when the number of distinct keys reaches maxBatchSize
+    void load(const Key& key, Callback callback)
+    {
+        pending[key].push_back(callback);
+        if (pending.size() >= maxBatchSize)
+            dispatch();
+    }
+
+    //! load all the scheduled items and call the callbacks
+    //! call it at the end of request or event loop iteration
+    void dispatch()
+    {
+        while (!pending.empty()) {
+            // callbacks may schedule new loads
+            std::map<Key, std::vector<Callback>> batch;
+            batch.swap(pending);
+
+            std::vector<Key> keys;
+            keys.reserve(batch.size());
+            for (const auto& item : batch)
+                keys.push_back(item.first);
+
+            const std::list<DataType>& items = table.select(keyField + " IN ?", keys);
+            for (const DataType& item : items) {
+                auto it = batch.find(item.*keyMember);
+                if (it == batch.end())
+                    continue;
+                for (const Callback& callback : it->second)
+                    callback(&item);
+                batch.erase(it);
+            }
+
+            // not found
+            for (const auto& item : batch)
+                for (const Callback& callback : item.second)
+                    callback(nullptr);
+        }
+    }
+
+    //! number of distinct keys scheduled
+    inline std::size_t size() const
+    {
+        return pending.size();
+    }
+
+private:
+    BatchLoader(const BatchLoader&);
+    BatchLoader& operator=(const BatchLoader&);
+
+private:
+    Table<DataType>& table;
+    Key DataType::* keyMember;
+    std::string keyField;
+    std::size_t maxBatchSize;
+    std::map<Key, std::vector<Callback>> pending;
+};
+
+} // namespace ngrest
+
+#endif // NGREST_BATCHLOADER_H
@@ -18,6 +18,9 @@
  *  This file is part of ngrest-db: http://github.com/loentar/ngrest-db
  */
 
+#include <ngrest/utils/tostring.h>
+
+#include "Entity.h"
 #include "Db.h"
 
 namespace ngrest {
@@ -26,4 +29,59 @@ Db::~Db()
 {
 }
 
+std::string Db::getColumnType(const Field& field) const
+{
+    if (!field.dbType.empty())
+        return field.dbType;
+
+    switch (field.type) {
+    case Field::DataType::Char:
+        if (field.length > 0)
+            return "CHAR(" + toString(field.length) + ")";
+        break;
+
+    case Field::DataType::String:
+        if (field.length > 0)
+            return "VARCHAR(" + toString(field.length) + ")";
+        break;
+
+    case Field::DataType::Decimal:
+        if (field.precision > 0)
+            return "DECIMAL(" + toString(field.precision) + "," + toString(field.scale) + ")";
+        break;
+
+    default:;
+    }
+
+    return getTypeName(field.type);
+}
+
+std::string Db::getCreateIndexQuery(const Entity& entity, const Index& index) const
+{
+    std::string fieldsStr;
+    for (const std::string& field : index.fields)
+        fieldsStr += (fieldsStr.empty() ? "" : ", ") + field;
+
+    std::string query = (index.isUnique ? "CREATE UNIQUE INDEX " : "CREATE INDEX ") + index.name
+            + " ON " + entity.getTableName()
+            + (index.method.empty() ? "" : " USING " + index.method) + " (" + fieldsStr + ")";
+
+    if (!index.include.empty()) {
+        std::string includeStr;
+        for (const std::string& field : index.include)
+            includeStr += (includeStr.empty() ? "" : ", ") + field;
+        query += " INCLUDE (" + includeStr + ")";
+    }
+
+    if (!index.where.empty())
+        query += " WHERE " + index.where;
+
+    return query;
+}
+
+std::string Db::getEstimatedCountQuery(const std::string& /*table*/) const
+{
+    return std::string();
+}
+
 } // namespace ngrest
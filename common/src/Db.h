@@ -24,11 +24,14 @@
 #include <string>
 
 #include "Field.h"
+#include "Index.h"
 
 namespace ngrest {
 
 class QueryImpl;
 class Entity;
+template <typename... Args>
+class PreparedStatement;
 
 class Db
 {
@@ -37,9 +40,28 @@ public:
 
     virtual QueryImpl* newQuery() = 0;
 
+    //! prepare the statement to execute it many times with typed arguments
+    //! defined in PreparedStatement.h
+    template <typename... Args>
+    PreparedStatement<Args...> prepare(const std::string& query);
+
     virtual std::string getCreateTableQuery(const Entity& entity) const = 0;
     virtual const std::string& getTypeName(Field::DataType type) const = 0;
+    //! column type of the field in CREATE TABLE: DBMS specific type if set,
+    //! else the type name with length/precision applied
+    virtual std::string getColumnType(const Field& field) const;
     virtual std::string getExistingTablesQuery() const = 0;
+
+    //! CREATE INDEX statement for the index of the entity
+    //! empty string - the index is not supported by the DBMS and is not created
+    virtual std::string getCreateIndexQuery(const Entity& entity, const Index& index) const;
+    //! query returning the names of the indexes of the table, table name is bound to arg 0
+    virtual std::string getExistingIndexesQuery() const = 0;
+
+    //! query returning approximate number of rows in the table from statistics, table name is bound to arg 0.
+    //! the query returns NULL or negative number if the statistics is not available.
+    //! empty string - estimation is not supported
+    virtual std::string getEstimatedCountQuery(const std::string& table) const;
 };
 
 } // namespace ngrest
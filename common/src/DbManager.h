@@ -161,6 +161,12 @@ public:
             getTableByName(tableName)->create();
         }
 
+        // new tables are created with indexes, add the indexes declared after the table was created
+        for (unsigned long i = 0; i < getEntityCount(); ++i) {
+            if (existing.count(tables[i]->getEntity().getTableName()))
+                tables[i]->createIndexes();
+        }
+
         if (createdTables)
             *createdTables = toCreate;
 
@@ -27,11 +27,22 @@
 namespace ngrest {
 
 struct Field;
+struct Index;
 class Db;
 
 template <int>
 struct DataTypeWrapper;
 
+//! storage options of the table, each driver uses the options it supports
+struct TableOptions
+{
+    bool unlogged; // PostgreSQL: UNLOGGED table, not crash safe, not replicated
+    bool withoutRowid; // SQLite: WITHOUT ROWID, the table is clustered by primary key
+    std::string engine; // MySQL: ENGINE, empty - default
+    std::string rowFormat; // MySQL: ROW_FORMAT, empty - default
+    int fillFactor; // PostgreSQL: fillfactor in percents, 0 - default
+};
+
 //! parent class for code-generated entities
 class Entity
 {
@@ -42,8 +53,12 @@ public:
     virtual const std::string& getTableName() const = 0;
     virtual const std::list<std::string>& getFieldsNames() const = 0;
     virtual const std::string& getFieldsNamesStr() const = 0;
+    //! fields read by default selects: all except lazy ones
+    virtual const std::string& getSelectFieldsNamesStr() const = 0;
     virtual const std::string& getFieldsArgs() const = 0;
     virtual const std::list<Field>& getFields() const = 0;
+    virtual const std::list<Index>& getIndexes() const = 0;
+    virtual const TableOptions& getTableOptions() const = 0;
 };
 
 template <typename DataType>
@@ -55,6 +70,11 @@ constexpr unsigned long getEntityFieldsCount(); // implemented in codegenerated
 template <typename DataType>
 constexpr unsigned long getEntityIndex(); // implemented in codegenerated code
 
+//! access to the primary key of the entity, specialized in codegenerated code:
+//! typedef ... Type; static const Type& get(const DataType& data);
+template <typename DataType>
+struct PrimaryKey;
+
 } // namespace ngrest
 
 
@@ -47,6 +47,17 @@ struct Field
         Float,
         Enum,
         String,
+        SmallInt,
+        TinyInt,
+        Real, // single precision float
+        Char, // fixed-length string, length is set by Field::length
+        Date,
+        Timestamp,
+        Decimal, // exact numeric, precision and scale are set by Field::precision and Field::scale
+        Blob, // binary data, std::vector<char>
+        Json, // structure or list serialized to JSON, see JsonColumn.h
+        IntArray, // std::vector<int>, native array on PostgreSQL, JSON array elsewhere
+        StringArray, // std::vector<std::string>
         Last
     };
 
@@ -60,6 +71,10 @@ struct Field
     bool isAutoincrement;
     bool ignoreOnInsert;
     const ForeignKey* fk;
+    int length; // length of Char and String, 0 - DBMS default
+    int precision; // total number of digits of Decimal, 0 - DBMS default
+    int scale; // number of digits after the decimal point of Decimal
+    bool isLazy; // not read by default selects, see Table::fetchLazy
 };
 
 } // namespace ngrest
@@ -0,0 +1,141 @@
+/*
+ *  Copyright 2016 Utkin Dmitry <loentar@gmail.com>
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ *  This file is part of ngrest-db: http://github.com/loentar/ngrest-db
+ */
+
+#include <ctype.h>
+#include <string.h>
+
+#include <ngrest/utils/Exception.h>
+
+#include "Index.h"
+
+namespace ngrest {
+
+namespace {
+
+const char* whitespace = " \t\r\n";
+
+std::string trim(const std::string& str)
+{
+    std::string::size_type begin = str.find_first_not_of(whitespace);
+    if (begin == std::string::npos)
+        return std::string();
+    std::string::size_type end = str.find_last_not_of(whitespace);
+    return str.substr(begin, end - begin + 1);
+}
+
+//! if the str starts with the keyword, skip it and following whitespace
+bool skipKeyword(std::string& str, const char* keyword)
+{
+    const std::string::size_type size = strlen(keyword);
+    if (str.size() < size)
+        return false;
+
+    for (std::string::size_type i = 0; i < size; ++i)
+        if (tolower(static_cast<unsigned char>(str[i])) != keyword[i])
+            return false;
+
+    if (str.size() > size && (isalnum(static_cast<unsigned char>(str[size])) || str[size] == '_'))
+        return false;
+
+    str = trim(str.substr(size));
+    return true;
+}
+
+//! parse "(a, b)" list at the beginning of the str and remove it
+std::list<std::string> parseNames(std::string& str, const std::string& declaration)
+{
+    NGREST_ASSERT(!str.empty() && str[0] == '(', "'(' expected in index declaration: " + declaration);
+    std::string::size_type end = str.find(')');
+    NGREST_ASSERT(end != std::string::npos, "')' expected in index declaration: " + declaration);
+
+    std::list<std::string> names;
+    std::string::size_type begin = 1;
+    while (begin < end) {
+        std::string::size_type comma = str.find(',', begin);
+        if (comma == std::string::npos || comma > end)
+            comma = end;
+        const std::string& name = trim(str.substr(begin, comma - begin));
+        NGREST_ASSERT(!name.empty(), "Empty field name in index declaration: " + declaration);
+        names.push_back(name);
+        begin = comma + 1;
+    }
+    NGREST_ASSERT(!names.empty(), "No fields in index declaration: " + declaration);
+
+    str = trim(str.substr(end + 1));
+    return names;
+}
+
+} // namespace
+
+Index Index::parse(const std::string& declaration)
+{
+    Index index;
+    std::string rest = trim(declaration);
+
+    index.isUnique = skipKeyword(rest, "unique");
+
+    std::string::size_type pos = rest.find('(');
+    NGREST_ASSERT(pos != std::string::npos, "'(' expected in index declaration: " + declaration);
+    index.name = trim(rest.substr(0, pos));
+    NGREST_ASSERT(!index.name.empty(), "Index name expected: " + declaration);
+    rest.erase(0, pos);
+
+    index.fields = parseNames(rest, declaration);
+
+    if (skipKeyword(rest, "using")) {
+        std::string::size_type end = rest.find_first_of(whitespace);
+        index.method = rest.substr(0, end);
+        NGREST_ASSERT(!index.method.empty(), "Index method expected: " + declaration);
+        rest = (end == std::string::npos) ? std::string() : trim(rest.substr(end));
+    }
+
+    if (skipKeyword(rest, "include"))
+        index.include = parseNames(rest, declaration);
+
+    if (skipKeyword(rest, "where")) {
+        NGREST_ASSERT(!rest.empty(), "Condition expected in index declaration: " + declaration);
+        index.where = rest;
+    } else {
+        NGREST_ASSERT(rest.empty(), "Unexpected '" + rest + "' in index declaration: " + declaration);
+    }
+
+    return index;
+}
+
+std::list<Index> Index::parseList(const std::string& declarations)
+{
+    std::list<Index> indexes;
+    std::string::size_type begin = 0;
+    while (begin < declarations.size()) {
+        std::string::size_type end = declarations.find(';', begin);
+        if (end == std::string::npos)
+            end = declarations.size();
+
+        const std::string& declaration = trim(declarations.substr(begin, end - begin));
+        if (!declaration.empty())
+            indexes.push_back(parse(declaration));
+
+        begin = end + 1;
+    }
+
+    return indexes;
+}
+
+} // namespace ngrest
@@ -0,0 +1,49 @@
+/*
+ *  Copyright 2016 Utkin Dmitry <loentar@gmail.com>
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ *  This file is part of ngrest-db: http://github.com/loentar/ngrest-db
+ */
+
+#ifndef NGREST_DB_INDEX_H
+#define NGREST_DB_INDEX_H
+
+#include <list>
+#include <string>
+
+namespace ngrest {
+
+//! secondary index description of code-generated entities
+struct Index
+{
+    std::string name;
+    std::list<std::string> fields;
+    std::list<std::string> include; // covering columns, not a part of the key
+    std::string where; // condition of partial index, can be empty
+    std::string method; // index access method, e.g. gin, empty - default
+    bool isUnique = false;
+
+    //! parse the declaration:
+    //! [unique] name(field1, field2) [using method] [include(field3)] [where condition]
+    static Index parse(const std::string& declaration);
+
+    //! parse the declarations separated by ';'
+    static std::list<Index> parseList(const std::string& declarations);
+};
+
+} // namespace ngrest
+
+#endif // NGREST_DB_INDEX_H
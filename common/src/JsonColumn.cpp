@@ -0,0 +1,374 @@
+/*
+ *  Copyright 2016 Utkin Dmitry <loentar@gmail.com>
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ *  This file is part of ngrest-db: http://github.com/loentar/ngrest-db
+ */
+
+#include <locale.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <ngrest/utils/Exception.h>
+#include <ngrest/utils/tostring.h>
+
+#include "JsonColumn.h"
+
+namespace ngrest {
+
+namespace {
+
+// printf and strtod use the decimal point of the current C locale, JSON always uses '.'
+void replaceDecimalPoint(std::string& number, const char* from, const char* to)
+{
+    const std::string::size_type pos = number.find(from);
+    if (pos != std::string::npos)
+        number.replace(pos, strlen(from), to);
+}
+
+} // namespace
+
+JsonColumnWriter::JsonColumnWriter(std::string& out_):
+    out(out_)
+{
+}
+
+void JsonColumnWriter::beginObject()
+{
+    separate();
+    out += '{';
+    needComma = false;
+}
+
+void JsonColumnWriter::endObject()
+{
+    out += '}';
+    needComma = true;
+}
+
+void JsonColumnWriter::beginArray()
+{
+    separate();
+    out += '[';
+    needComma = false;
+}
+
+void JsonColumnWriter::endArray()
+{
+    out += ']';
+    needComma = true;
+}
+
+void JsonColumnWriter::key(const char* name)
+{
+    separate();
+    out += '"';
+    out += name;
+    out += "\":";
+    needComma = false;
+}
+
+void JsonColumnWriter::writeNull()
+{
+    separate();
+    out += "null";
+    needComma = true;
+}
+
+void JsonColumnWriter::writeBool(bool value)
+{
+    separate();
+    out += value ? "true" : "false";
+    needComma = true;
+}
+
+void JsonColumnWriter::writeInt(int64_t value)
+{
+    separate();
+    out += toString(value);
+    needComma = true;
+}
+
+void JsonColumnWriter::writeFloat(double value)
+{
+    // JSON has no NaN and infinity
+    if (!isfinite(value)) {
+        writeNull();
+        return;
+    }
+
+    separate();
+    char buffer[32];
+    // enough digits to read the same value back
+    snprintf(buffer, sizeof(buffer), "%.17g", value);
+    std::string number(buffer);
+    const char* decimalPoint = localeconv()->decimal_point;
+    if (strcmp(decimalPoint, "."))
+        replaceDecimalPoint(number, decimalPoint, ".");
+    out += number;
+    needComma = true;
+}
+
+void JsonColumnWriter::writeString(const std::string& value)
+{
+    static const char* hex = "0123456789abcdef";
+
+    separate();
+    out.reserve(out.size() + value.size() + 2);
+    out += '"';
+    for (char ch : value) {
+        switch (ch) {
+        case '"': out += "\\\""; break;
+        case '\\': out += "\\\\"; break;
+        case '\n': out += "\\n"; break;
+        case '\r': out += "\\r"; break;
+        case '\t': out += "\\t"; break;
+        case '\b': out += "\\b"; break;
+        case '\f': out += "\\f"; break;
+        default:
+            if (static_cast<unsigned char>(ch) < 0x20) {
+                out += "\\u00";
+                out += hex[(ch >> 4) & 0xf];
+                out += hex[ch & 0xf];
+            } else {
+                out += ch;
+            }
+        }
+    }
+    out += '"';
+    needComma = true;
+}
+
+void JsonColumnWriter::separate()
+{
+    if (needComma)
+        out += ',';
+}
+
+
+JsonColumnReader::JsonColumnReader(const char* data, std::size_t size):
+    pos(data), end(data + size)
+{
+}
+
+bool JsonColumnReader::isNull()
+{
+    if (peek() != 'n')
+        return false;
+    expectWord("null");
+    return true;
+}
+
+void JsonColumnReader::beginObject()
+{
+    expect('{');
+}
+
+bool JsonColumnReader::nextKey(std::string& key)
+{
+    char ch = peek();
+    if (ch == '}') {
+        ++pos;
+        return false;
+    }
+    if (ch == ',')
+        ++pos;
+
+    readString(key);
+    expect(':');
+    return true;
+}
+
+void JsonColumnReader::beginArray()
+{
+    expect('[');
+}
+
+bool JsonColumnReader::nextItem()
+{
+    char ch = peek();
+    if (ch == ']') {
+        ++pos;
+        return false;
+    }
+    if (ch == ',')
+        ++pos;
+    return true;
+}
+
+bool JsonColumnReader::readBool()
+{
+    if (peek() == 't') {
+        expectWord("true");
+        return true;
+    }
+    expectWord("false");
+    return false;
+}
+
+int64_t JsonColumnReader::readInt()
+{
+    const char* begin = readNumber();
+    char* numEnd = nullptr;
+    int64_t value = strtoll(begin, &numEnd, 10);
+    if (*numEnd) // fraction or exponent
+        value = static_cast<int64_t>(strtod(begin, nullptr));
+    return value;
+}
+
+double JsonColumnReader::readFloat()
+{
+    return strtod(readNumber(), nullptr);
+}
+
+void JsonColumnReader::readString(std::string& value)
+{
+    expect('"');
+    value.clear();
+    for (;;) {
+        NGREST_ASSERT(pos < end, "Unterminated string in JSON");
+        char ch = *pos++;
+        if (ch == '"')
+            break;
+        if (ch != '\\') {
+            value += ch;
+            continue;
+        }
+
+        NGREST_ASSERT(pos < end, "Unterminated string in JSON");
+        ch = *pos++;
+        switch (ch) {
+        case 'n': value += '\n'; break;
+        case 'r': value += '\r'; break;
+        case 't': value += '\t'; break;
+        case 'b': value += '\b'; break;
+        case 'f': value += '\f'; break;
+        case 'u': {
+            NGREST_ASSERT(end - pos >= 4, "Invalid escape sequence in JSON");
+            const std::string hexStr(pos, 4);
+            unsigned long code = strtoul(hexStr.c_str(), nullptr, 16);
+            pos += 4;
+            // surrogate pair
+            if (code >= 0xd800 && code < 0xdc00 && end - pos >= 6 && pos[0] == '\\' && pos[1] == 'u') {
+                const std::string lowStr(pos + 2, 4);
+                code = 0x10000 + ((code - 0xd800) << 10) + (strtoul(lowStr.c_str(), nullptr, 16) - 0xdc00);
+                pos += 6;
+            }
+
+            // encode to UTF-8
+            if (code < 0x80) {
+                value += static_cast<char>(code);
+            } else if (code < 0x800) {
+                value += static_cast<char>(0xc0 | (code >> 6));
+                value += static_cast<char>(0x80 | (code & 0x3f));
+            } else if (code < 0x10000) {
+                value += static_cast<char>(0xe0 | (code >> 12));
+                value += static_cast<char>(0x80 | ((code >> 6) & 0x3f));
+                value += static_cast<char>(0x80 | (code & 0x3f));
+            } else {
+                value += static_cast<char>(0xf0 | (code >> 18));
+                value += static_cast<char>(0x80 | ((code >> 12) & 0x3f));
+                value += static_cast<char>(0x80 | ((code >> 6) & 0x3f));
+                value += static_cast<char>(0x80 | (code & 0x3f));
+            }
+            break;
+        }
+        default: // '"', '\\', '/'
+            value += ch;
+        }
+    }
+}
+
+void JsonColumnReader::skipValue()
+{
+    std::string str;
+    switch (peek()) {
+    case '{':
+        beginObject();
+        while (nextKey(str))
+            skipValue();
+        break;
+
+    case '[':
+        beginArray();
+        while (nextItem())
+            skipValue();
+        break;
+
+    case '"':
+        readString(str);
+        break;
+
+    case 't':
+    case 'f':
+        readBool();
+        break;
+
+    case 'n':
+        expectWord("null");
+        break;
+
+    default:
+        readNumber();
+    }
+}
+
+bool JsonColumnReader::isEnd()
+{
+    while (pos < end && *pos && strchr(" \t\r\n", *pos))
+        ++pos;
+    return pos == end;
+}
+
+char JsonColumnReader::peek()
+{
+    NGREST_ASSERT(!isEnd(), "Unexpected end of JSON");
+    return *pos;
+}
+
+void JsonColumnReader::expect(char ch)
+{
+    NGREST_ASSERT(peek() == ch, std::string("'") + ch + "' expected in JSON");
+    ++pos;
+}
+
+void JsonColumnReader::expectWord(const char* word)
+{
+    const std::size_t size = strlen(word);
+    NGREST_ASSERT(static_cast<std::size_t>(end - pos) >= size && !strncmp(pos, word, size),
+                  std::string("'") + word + "' expected in JSON");
+    pos += size;
+}
+
+const char* JsonColumnReader::readNumber()
+{
+    // the number is copied, because the data is not null-terminated
+    // and the decimal point is converted for strtod
+    peek();
+    const char* begin = pos;
+    while (pos < end && *pos && strchr("+-.0123456789eE", *pos))
+        ++pos;
+    NGREST_ASSERT(pos != begin, "Number expected in JSON");
+    number.assign(begin, pos);
+    const char* decimalPoint = localeconv()->decimal_point;
+    if (strcmp(decimalPoint, "."))
+        replaceDecimalPoint(number, ".", decimalPoint);
+    return number.c_str();
+}
+
+} // namespace ngrest
@@ -0,0 +1,248 @@
+/*
+ *  Copyright 2016 Utkin Dmitry <loentar@gmail.com>
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ *  This file is part of ngrest-db: http://github.com/loentar/ngrest-db
+ */
+
+#ifndef NGREST_DB_JSONCOLUMN_H
+#define NGREST_DB_JSONCOLUMN_H
+
+#include <stdint.h>
+#include <list>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include <ngrest/common/Nullable.h>
+
+namespace ngrest {
+
+//! writes the value of JSON column into the string
+class JsonColumnWriter
+{
+public:
+    explicit JsonColumnWriter(std::string& out);
+
+    void beginObject();
+    void endObject();
+    void beginArray();
+    void endArray();
+    void key(const char* name);
+
+    void writeNull();
+    void writeBool(bool value);
+    void writeInt(int64_t value);
+    void writeFloat(double value);
+    void writeString(const std::string& value);
+
+private:
+    void separate();
+
+private:
+    std::string& out;
+    bool needComma = false;
+};
+
+//! reads the value of JSON column without building intermediate tree
+class JsonColumnReader
+{
+public:
+    JsonColumnReader(const char* data, std::size_t size);
+
+    //! if the next value is null, skip it and return true
+    bool isNull();
+
+    void beginObject();
+    //! read the key of the next member of the object
+    //! returns false at the end of the object
+    bool nextKey(std::string& key);
+
+    void beginArray();
+    //! returns false at the end of the array
+    bool nextItem();
+
+    bool readBool();
+    int64_t readInt();
+    double readFloat();
+    void readString(std::string& value);
+
+    //! skip the value of the member unknown to the reader
+    void skipValue();
+
+    //! true if the rest of input is whitespace
+    bool isEnd();
+
+private:
+    char peek();
+    void expect(char ch);
+    void expectWord(const char* word);
+    const char* readNumber();
+
+private:
+    const char* pos;
+    const char* end;
+    std::string number;
+};
+
+
+inline void writeJson(JsonColumnWriter& writer, bool value)
+{
+    writer.writeBool(value);
+}
+
+template <typename T>
+inline typename std::enable_if<std::is_integral<T>::value || std::is_enum<T>::value>::type
+writeJson(JsonColumnWriter& writer, T value)
+{
+    writer.writeInt(static_cast<int64_t>(value));
+}
+
+inline void writeJson(JsonColumnWriter& writer, double value)
+{
+    writer.writeFloat(value);
+}
+
+inline void writeJson(JsonColumnWriter& writer, float value)
+{
+    writer.writeFloat(value);
+}
+
+inline void writeJson(JsonColumnWriter& writer, const std::string& value)
+{
+    writer.writeString(value);
+}
+
+template <typename T>
+void writeJson(JsonColumnWriter& writer, const Nullable<T>& value)
+{
+    if (value.isNull()) {
+        writer.writeNull();
+    } else {
+        writeJson(writer, *value);
+    }
+}
+
+template <typename Container>
+void writeJsonArray(JsonColumnWriter& writer, const Container& values)
+{
+    writer.beginArray();
+    for (const auto& value : values)
+        writeJson(writer, value);
+    writer.endArray();
+}
+
+template <typename T>
+void writeJson(JsonColumnWriter& writer, const std::list<T>& values)
+{
+    writeJsonArray(writer, values);
+}
+
+template <typename T>
+void writeJson(JsonColumnWriter& writer, const std::vector<T>& values)
+{
+    writeJsonArray(writer, values);
+}
+
+
+inline void readJson(JsonColumnReader& reader, bool& value)
+{
+    value = reader.readBool();
+}
+
+template <typename T>
+inline typename std::enable_if<std::is_integral<T>::value || std::is_enum<T>::value>::type
+readJson(JsonColumnReader& reader, T& value)
+{
+    value = static_cast<T>(reader.readInt());
+}
+
+inline void readJson(JsonColumnReader& reader, double& value)
+{
+    value = reader.readFloat();
+}
+
+inline void readJson(JsonColumnReader& reader, float& value)
+{
+    value = static_cast<float>(reader.readFloat());
+}
+
+inline void readJson(JsonColumnReader& reader, std::string& value)
+{
+    reader.readString(value);
+}
+
+template <typename T>
+void readJson(JsonColumnReader& reader, Nullable<T>& value)
+{
+    if (reader.isNull()) {
+        value.setNull();
+    } else {
+        readJson(reader, value.get());
+    }
+}
+
+template <typename Container>
+void readJsonArray(JsonColumnReader& reader, Container& values)
+{
+    values.clear();
+    if (reader.isNull())
+        return;
+
+    reader.beginArray();
+    while (reader.nextItem()) {
+        values.push_back(typename Container::value_type());
+        readJson(reader, values.back());
+    }
+}
+
+template <typename T>
+void readJson(JsonColumnReader& reader, std::list<T>& values)
+{
+    readJsonArray(reader, values);
+}
+
+template <typename T>
+void readJson(JsonColumnReader& reader, std::vector<T>& values)
+{
+    readJsonArray(reader, values);
+}
+
+
+//! serialize the value of the field stored as JSON
+//! structures are serialized by writeJson generated by ngrestcg
+template <typename T>
+std::string toJsonColumn(const T& value)
+{
+    std::string result;
+    JsonColumnWriter writer(result);
+    writeJson(writer, value);
+    return result;
+}
+
+//! parse the value of the field stored as JSON, empty data leaves the value unchanged
+template <typename T>
+void fromJsonColumn(const char* data, std::size_t size, T& value)
+{
+    JsonColumnReader reader(data, size);
+    if (reader.isEnd())
+        return;
+    readJson(reader, value);
+}
+
+} // namespace ngrest
+
+#endif // NGREST_DB_JSONCOLUMN_H
@@ -0,0 +1,125 @@
+/*
+ *  Copyright 2016 Utkin Dmitry <loentar@gmail.com>
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ *  This file is part of ngrest-db: http://github.com/loentar/ngrest-db
+ */
+
+#ifndef NGREST_PREPAREDSTATEMENT_H
+#define NGREST_PREPAREDSTATEMENT_H
+
+#include <string>
+
+#include "Db.h"
+#include "Query.h"
+
+namespace ngrest {
+
+template <int...>
+struct ArgIndexes
+{
+};
+
+template <int Count, int... Indexes>
+struct MakeArgIndexes: MakeArgIndexes<Count - 1, Count - 1, Indexes...>
+{
+};
+
+template <int... Indexes>
+struct MakeArgIndexes<0, Indexes...>
+{
+    typedef ArgIndexes<Indexes...> Type;
+};
+
+//! statement prepared once and executed many times with typed arguments
+//! owns the driver's statement (and the connection for the drivers which use connection per query).
+//! not thread safe: use one statement per thread. must be destroyed before the Db
+template <typename... Args>
+class PreparedStatement
+{
+public:
+    PreparedStatement(Db& db, const std::string& queryStr):
+        query(db)
+    {
+        query.prepare(queryStr);
+    }
+
+    PreparedStatement(PreparedStatement&& other):
+        query(std::move(other.query)),
+        isExecuted(other.isExecuted)
+    {
+    }
+
+    //! bind the arguments and execute the statement
+    //! returns true if there is a row to read using result() and next()
+    bool execute(const Args&... args)
+    {
+        if (isExecuted)
+            query.rewind();
+        isExecuted = true;
+
+        bindArgs(typename MakeArgIndexes<sizeof...(Args)>::Type(), args...);
+        return query.next();
+    }
+
+    //! go to the next row of the result
+    inline bool next()
+    {
+        return query.next();
+    }
+
+    template <typename T>
+    inline void result(int column, T& value)
+    {
+        query.result(column, value);
+    }
+
+    inline int64_t lastInsertId()
+    {
+        return query.lastInsertId();
+    }
+
+    inline Query& getQuery()
+    {
+        return query;
+    }
+
+private:
+    PreparedStatement(const PreparedStatement&);
+    PreparedStatement& operator=(const PreparedStatement&);
+
+    template <int... Indexes>
+    inline void bindArgs(ArgIndexes<Indexes...>, const Args&... args)
+    {
+        // expands to query.bind(0, arg0), query.bind(1, arg1), ...
+        int expand[] = {0, (query.bind(Indexes, args), 0)...};
+        (void) expand;
+    }
+
+private:
+    Query query;
+    bool isExecuted = false;
+};
+
+template <typename... Args>
+PreparedStatement<Args...> Db::prepare(const std::string& query)
+{
+    return PreparedStatement<Args...>(*this, query);
+}
+
+} // namespace ngrest
+
+#endif // NGREST_PREPAREDSTATEMENT_H
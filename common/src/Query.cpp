@@ -18,11 +18,61 @@
  *  This file is part of ngrest-db: http://github.com/loentar/ngrest-db
  */
 
+#include <ctype.h>
+#include <string.h>
+
+#include <ngrest/utils/Exception.h>
+#include <ngrest/utils/tostring.h>
+
 #include "Db.h"
 #include "Query.h"
 
 namespace ngrest {
 
+namespace {
+
+inline bool isIdentifierChar(char ch)
+{
+    return isalnum(static_cast<unsigned char>(ch)) || ch == '_';
+}
+
+inline bool isSpace(char ch)
+{
+    return ch == ' ' || ch == '\t' || ch == '\r' || ch == '\n';
+}
+
+//! check the keyword ends at pos and return it's start, or npos if the keyword isn't found
+std::string::size_type findKeywordBefore(const std::string& query, std::string::size_type pos,
+                                         std::string::size_type begin, const char* keyword)
+{
+    while (pos > begin && isSpace(query[pos - 1]))
+        --pos;
+
+    std::string::size_type size = strlen(keyword);
+    if ((pos - begin) < size)
+        return std::string::npos;
+
+    std::string::size_type start = pos - size;
+    for (std::string::size_type i = 0; i < size; ++i)
+        if (toupper(static_cast<unsigned char>(query[start + i])) != keyword[i])
+            return std::string::npos;
+
+    if (start > 0 && isIdentifierChar(query[start - 1]))
+        return std::string::npos;
+
+    return start;
+}
+
+//! returns the position of the quote closing the literal or identifier which starts at pos
+std::string::size_type skipQuoted(const std::string& query, std::string::size_type pos)
+{
+    // doubled quote inside of literal is handled as two literals in a row
+    const std::string::size_type end = query.find(query[pos], pos + 1);
+    return (end != std::string::npos) ? end : query.size();
+}
+
+} // namespace
+
 Query::Query(Db& db):
     impl(db.newQuery())
 {
@@ -34,14 +84,75 @@ Query::Query(QueryImpl* impl_):
 
 }
 
+Query::Query(Query&& other):
+    impl(other.impl)
+{
+    other.impl = nullptr;
+}
+
 Query::~Query()
 {
     delete impl;
 }
 
+std::string Query::expandLists(const std::string& query, ListParam* lists, int count)
+{
+    std::string result;
+    result.reserve(query.size() + 32);
+
+    std::string::size_type begin = 0;
+    int param = 0;
+    int paramCount = 0;
+    for (std::string::size_type pos = 0; pos < query.size(); ++pos) {
+        const char ch = query[pos];
+        if (ch == '\'' || ch == '"' || ch == '`') {
+            pos = skipQuoted(query, pos);
+            continue;
+        }
+
+        if (ch != '?' || (pos > 0 && query[pos - 1] == '\\'))
+            continue;
+
+        if (param < count && lists[param].isList) {
+            std::string::size_type start = findKeywordBefore(query, pos, begin, "IN");
+            if (start == std::string::npos) {
+                NGREST_ASSERT(lists[param].isArray, "List parameter #" + toString(param)
+                              + " must follow IN keyword: " + query);
+                // array column value
+                lists[param].asValue = true;
+                ++param;
+                ++paramCount;
+                continue;
+            }
 
+            std::string::size_type notStart = findKeywordBefore(query, start, begin, "NOT");
+            const bool negate = notStart != std::string::npos;
+            if (negate)
+                start = notStart;
 
+            std::string expr;
+            lists[param].placeholders = impl->expandInList(lists[param].itemType, lists[param].size,
+                                                           negate, expr);
+            result.append(query, begin, start - begin);
+            result += expr;
+            begin = pos + 1;
 
+            // 0 - the list is bound as one parameter, -1 - no parameters
+            paramCount += (lists[param].placeholders > 0) ? lists[param].placeholders
+                                                          : (lists[param].placeholders + 1);
+        } else {
+            ++paramCount;
+        }
 
+        ++param;
+    }
+
+    NGREST_ASSERT(paramCount <= impl->maxParamCount(), "Statement has " + toString(paramCount)
+                  + " parameters after expanding IN lists, the limit is " + toString(impl->maxParamCount())
+                  + ": " + query);
+
+    result.append(query, begin, std::string::npos);
+    return result;
+}
 
 } // namespace ngrest
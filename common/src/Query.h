@@ -21,22 +21,52 @@
 #ifndef NGREST_QUERY_H
 #define NGREST_QUERY_H
 
+#include <list>
+#include <set>
 #include <string>
 #include <tuple>
+#include <vector>
+#if __cplusplus >= 201703L
+#include <string_view>
+#endif
 
 #include <ngrest/common/Nullable.h>
+#include <ngrest/utils/tostring.h>
 
 #include "QueryImpl.h"
+#include "JsonColumn.h"
 
 namespace ngrest {
 
 class Db;
 
+template <typename T>
+struct ListItemType
+{
+    static const Field::DataType value = Field::DataType::String;
+};
+
+template <> struct ListItemType<bool> { static const Field::DataType value = Field::DataType::Bool; };
+template <> struct ListItemType<char> { static const Field::DataType value = Field::DataType::Int; };
+template <> struct ListItemType<signed char> { static const Field::DataType value = Field::DataType::Int; };
+template <> struct ListItemType<short> { static const Field::DataType value = Field::DataType::Int; };
+template <> struct ListItemType<int> { static const Field::DataType value = Field::DataType::Int; };
+template <> struct ListItemType<unsigned char> { static const Field::DataType value = Field::DataType::Int; };
+template <> struct ListItemType<unsigned short> { static const Field::DataType value = Field::DataType::Int; };
+template <> struct ListItemType<long> { static const Field::DataType value = Field::DataType::BigInt; };
+template <> struct ListItemType<long long> { static const Field::DataType value = Field::DataType::BigInt; };
+template <> struct ListItemType<unsigned int> { static const Field::DataType value = Field::DataType::BigInt; };
+template <> struct ListItemType<unsigned long> { static const Field::DataType value = Field::DataType::BigInt; };
+template <> struct ListItemType<unsigned long long> { static const Field::DataType value = Field::DataType::BigInt; };
+template <> struct ListItemType<float> { static const Field::DataType value = Field::DataType::Float; };
+template <> struct ListItemType<double> { static const Field::DataType value = Field::DataType::Float; };
+
 class Query
 {
 public:
     Query(Db& db);
     Query(QueryImpl* impl);
+    Query(Query&& other);
 
     ~Query();
 
@@ -56,6 +86,35 @@ public:
         impl->prepare(query);
     }
 
+    //! prepare the query and bind the parameters
+    //! std::list, std::vector or std::set parameter following IN or NOT IN is expanded
+    //! using the driver specific expression: "id IN ?" with {1, 2, 3}.
+    //! the text of the statement depends only on the bucket of the list size,
+    //! so the server can reuse the plan for the lists of different sizes.
+    //! std::vector<int> or std::vector<std::string> elsewhere is bound as array value: "groups @> ?"
+    template <typename... Params>
+    inline void prepare(const std::string& query, const Params&... params)
+    {
+        ListParam lists[] = {getListParam(params)...};
+        bool hasLists = false;
+        for (const ListParam& list : lists)
+            hasLists |= list.isList;
+
+        if (hasLists) {
+            impl->prepare(expandLists(query, lists, sizeof...(Params)));
+        } else {
+            impl->prepare(query);
+        }
+
+        bindExpanded(0, lists, params...);
+    }
+
+    //! prepare the statement to be executed again with new values bound
+    inline void rewind()
+    {
+        impl->rewind();
+    }
+
 
     inline void bindNull(int arg)
     {
@@ -77,6 +136,11 @@ public:
         impl->bindInt(arg, value);
     }
 
+    inline void bind(int arg, signed char value)
+    {
+        impl->bindInt(arg, value);
+    }
+
     inline void bind(int arg, int value)
     {
         impl->bindInt(arg, value);
@@ -144,6 +208,81 @@ public:
         impl->bindString(arg, value);
     }
 
+#if __cplusplus >= 201703L
+    //! the value is not copied, see bindBorrowed
+    inline void bind(int arg, std::string_view value)
+    {
+        impl->bindStringRef(arg, value.data(), value.size(), false);
+    }
+#endif
+
+    inline void bind(int arg, const std::vector<char>& value)
+    {
+        impl->bindBlob(arg, value.data(), value.size());
+    }
+
+    inline void bind(int arg, const std::vector<int>& values)
+    {
+        impl->bindIntArray(arg, values);
+    }
+
+    inline void bind(int arg, const std::vector<std::string>& values)
+    {
+        impl->bindStringArray(arg, values);
+    }
+
+    //! bind the value serialized to JSON, see JsonColumn.h
+    template <typename T>
+    inline void bindJson(int arg, const T& value)
+    {
+        impl->bindString(arg, toJsonColumn(value));
+    }
+
+    template <typename T>
+    inline void bindJson(int arg, const Nullable<T>& value)
+    {
+        if (value.isNull()) {
+            impl->bindNull(arg);
+        } else {
+            bindJson(arg, *value);
+        }
+    }
+
+    //! bind binary data read by chunks, see QueryImpl::bindBlobStream
+    inline void bindBlobStream(int arg, const QueryImpl::BlobReader& reader)
+    {
+        impl->bindBlobStream(arg, reader);
+    }
+
+    //! bind the string without copying it
+    //! the value must stay valid and unchanged until the statement is executed
+    //! or another value is bound to the same arg
+    inline void bindBorrowed(int arg, const std::string& value)
+    {
+        impl->bindStringRef(arg, value.c_str(), value.size(), true);
+    }
+
+    inline void bindBorrowed(int arg, const char* value, std::size_t size)
+    {
+        impl->bindStringRef(arg, value, size, false);
+    }
+
+    //! the data is not copied, see bindBorrowed
+    inline void bindBorrowed(int arg, const std::vector<char>& value)
+    {
+        impl->bindBlobRef(arg, value.data(), value.size());
+    }
+
+    template <typename T>
+    inline void bindBorrowed(int arg, const Nullable<T>& value)
+    {
+        if (value.isNull()) {
+            impl->bindNull(arg);
+        } else {
+            bindBorrowed(arg, *value);
+        }
+    }
+
     template <typename T>
     inline void bind(int arg, const Nullable<T>& value)
     {
@@ -183,6 +322,11 @@ public:
         value = static_cast<char>(impl->resultInt(column));
     }
 
+    inline void result(int column, signed char& value)
+    {
+        value = static_cast<signed char>(impl->resultInt(column));
+    }
+
     inline void result(int column, int& value)
     {
         value = impl->resultInt(column);
@@ -245,6 +389,50 @@ public:
         impl->resultString(column, value);
     }
 
+#if __cplusplus >= 201703L
+    //! the value is valid until next() or reset()
+    inline void result(int column, std::string_view& value)
+    {
+        value = resultStringView(column);
+    }
+#endif
+
+    inline void result(int column, std::vector<int>& values)
+    {
+        impl->resultIntArray(column, values);
+    }
+
+    inline void result(int column, std::vector<std::string>& values)
+    {
+        impl->resultStringArray(column, values);
+    }
+
+    //! parse the value of JSON column, see JsonColumn.h
+    template <typename T>
+    inline void resultJson(int column, T& value)
+    {
+        std::size_t size = 0;
+        const char* json = impl->resultStringRef(column, size);
+        fromJsonColumn(json, size, value);
+    }
+
+    template <typename T>
+    inline void resultJson(int column, Nullable<T>& value)
+    {
+        if (impl->resultIsNull(column)) {
+            value.setNull();
+        } else {
+            resultJson(column, value.get());
+        }
+    }
+
+    inline void result(int column, std::vector<char>& value)
+    {
+        std::size_t size = 0;
+        const char* data = impl->resultBlobRef(column, size);
+        value.assign(data, data + size);
+    }
+
     template <typename T>
     inline void result(int column, Nullable<T>& value)
     {
@@ -293,6 +481,31 @@ public:
         impl->resultString(column, value);
     }
 
+    //! get the string value of the column without copying
+    //! the value is not null terminated and valid until next() or reset()
+    inline const char* resultStringRef(int column, std::size_t& length)
+    {
+        return impl->resultStringRef(column, length);
+    }
+
+    //! get the binary value of the column without copying
+    //! the value is valid until next() or reset()
+    inline const char* resultBlobRef(int column, std::size_t& size)
+    {
+        return impl->resultBlobRef(column, size);
+    }
+
+#if __cplusplus >= 201703L
+    //! get the string value of the column without copying
+    //! the value is valid until next() or reset()
+    inline std::string_view resultStringView(int column)
+    {
+        std::size_t length = 0;
+        const char* value = impl->resultStringRef(column, length);
+        return std::string_view(value, length);
+    }
+#endif
+
     inline QueryImpl* take()
     {
         QueryImpl* res = impl;
@@ -305,7 +518,215 @@ public:
         return impl->lastInsertId();
     }
 
+    inline bool send()
+    {
+        return impl->send();
+    }
+
+    inline bool poll()
+    {
+        return impl->poll();
+    }
+
+    inline int socket()
+    {
+        return impl->socket();
+    }
+
+    //! memory used by the query for parameters and results in bytes
+    inline std::size_t bufferSize()
+    {
+        return impl->bufferSize();
+    }
+
+    inline void beginBatch()
+    {
+        impl->beginBatch();
+    }
+
+    inline void endBatch()
+    {
+        impl->endBatch();
+    }
+
 private:
+    struct ListParam
+    {
+        bool isList = false;
+        std::size_t size = 0;
+        Field::DataType itemType = Field::DataType::Unknown;
+        //! number of placeholders the list is expanded to, 0 - bound as array, -1 - nothing is bound
+        int placeholders = 0;
+        //! std::vector<int> or std::vector<std::string>: can be bound as array value
+        bool isArray = false;
+        //! not following IN, bound as array value
+        bool asValue = false;
+    };
+
+    //! replace "IN ?" for each list parameter with the driver's expression
+    std::string expandLists(const std::string& query, ListParam* lists, int count);
+
+    template <typename T>
+    inline static ListParam getListParam(const T&)
+    {
+        return ListParam();
+    }
+
+    template <typename T>
+    inline static ListParam getListParam(const std::list<T>& values)
+    {
+        return makeListParam<T>(values.size());
+    }
+
+    template <typename T>
+    inline static ListParam getListParam(const std::vector<T>& values)
+    {
+        return makeListParam<T>(values.size());
+    }
+
+    template <typename T>
+    inline static ListParam getListParam(const std::set<T>& values)
+    {
+        return makeListParam<T>(values.size());
+    }
+
+    // binary data, not a list
+    inline static ListParam getListParam(const std::vector<char>&)
+    {
+        return ListParam();
+    }
+
+    inline static ListParam getListParam(const std::vector<int>& values)
+    {
+        ListParam list = makeListParam<int>(values.size());
+        list.isArray = true;
+        return list;
+    }
+
+    inline static ListParam getListParam(const std::vector<std::string>& values)
+    {
+        ListParam list = makeListParam<std::string>(values.size());
+        list.isArray = true;
+        return list;
+    }
+
+    template <typename T>
+    inline static ListParam makeListParam(std::size_t size)
+    {
+        ListParam list;
+        list.isList = true;
+        list.size = size;
+        list.itemType = ListItemType<T>::value;
+        return list;
+    }
+
+    inline void bindExpanded(int, const ListParam*)
+    {
+    }
+
+    template <typename Param1, typename... Params>
+    inline void bindExpanded(int index, const ListParam* list, const Param1& param1, const Params&... params)
+    {
+        bindExpanded(bindParam(index, *list, param1), list + 1, params...);
+    }
+
+    template <typename T>
+    inline int bindParam(int index, const ListParam&, const T& value)
+    {
+        bind(index, value);
+        return index + 1;
+    }
+
+    template <typename T>
+    inline int bindParam(int index, const ListParam& list, const std::list<T>& values)
+    {
+        return bindList(index, list, values);
+    }
+
+    template <typename T>
+    inline int bindParam(int index, const ListParam& list, const std::vector<T>& values)
+    {
+        return bindList(index, list, values);
+    }
+
+    template <typename T>
+    inline int bindParam(int index, const ListParam& list, const std::set<T>& values)
+    {
+        return bindList(index, list, values);
+    }
+
+    inline int bindParam(int index, const ListParam&, const std::vector<char>& value)
+    {
+        bind(index, value);
+        return index + 1;
+    }
+
+    inline int bindParam(int index, const ListParam& list, const std::vector<int>& values)
+    {
+        if (!list.asValue)
+            return bindList(index, list, values);
+
+        bind(index, values);
+        return index + 1;
+    }
+
+    inline int bindParam(int index, const ListParam& list, const std::vector<std::string>& values)
+    {
+        if (!list.asValue)
+            return bindList(index, list, values);
+
+        bind(index, values);
+        return index + 1;
+    }
+
+    template <typename Container>
+    int bindList(int index, const ListParam& list, const Container& values)
+    {
+        if (list.placeholders < 0)
+            return index;
+
+        if (!list.placeholders) {
+            std::vector<std::string> items;
+            items.reserve(values.size());
+            for (const auto& value : values)
+                items.push_back(listItemToString(value));
+            impl->bindArray(index, list.itemType, items);
+            return index + 1;
+        }
+
+        int arg = index;
+        for (const auto& value : values)
+            bind(arg++, value);
+
+        // fill the rest of the bucket: repeating the last item does not change the result
+        const int end = index + list.placeholders;
+        for (; arg < end; ++arg)
+            bind(arg, *values.rbegin());
+
+        return end;
+    }
+
+    inline static std::string listItemToString(const std::string& value)
+    {
+        return value;
+    }
+
+    inline static std::string listItemToString(const char* value)
+    {
+        return value;
+    }
+
+    inline static std::string listItemToString(bool value)
+    {
+        return value ? "true" : "false";
+    }
+
+    template <typename T>
+    inline static std::string listItemToString(const T& value)
+    {
+        return toString(value);
+    }
+
     inline void bindNext(int)
     {
     }
@@ -336,6 +757,10 @@ private:
         resultItem<Tuple, sizeof...(Args)>(tuple);
     }
 
+private:
+    Query(const Query&);
+    Query& operator=(const Query&);
+
 private:
     QueryImpl* impl;
 };
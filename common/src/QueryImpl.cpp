@@ -18,6 +18,10 @@
  *  This file is part of ngrest-db: http://github.com/loentar/ngrest-db
  */
 
+#include <ngrest/utils/Exception.h>
+#include <ngrest/utils/tostring.h>
+
+#include "JsonColumn.h"
 #include "QueryImpl.h"
 
 namespace ngrest {
@@ -26,4 +30,145 @@ QueryImpl::~QueryImpl()
 {
 }
 
+int QueryImpl::expandInList(Field::DataType /*itemType*/, std::size_t size, bool negate, std::string& expr)
+{
+    if (!size) {
+        // "IN ()" is not supported by every DBMS, the left operand stays in place so use an empty subquery
+        expr = negate ? "NOT IN (SELECT NULL FROM (SELECT 1) AS e WHERE 1=0)"
+                      : "IN (SELECT NULL FROM (SELECT 1) AS e WHERE 1=0)";
+        return -1;
+    }
+
+    const int maxCount = maxParamCount();
+    NGREST_ASSERT(size <= static_cast<std::size_t>(maxCount), "IN list of " + toString(size)
+                  + " items exceeds the limit of " + toString(maxCount) + " parameters per statement");
+
+    int count = 8;
+    while (static_cast<std::size_t>(count) < size)
+        count *= 2;
+    if (count > maxCount)
+        count = maxCount;
+
+    expr = negate ? "NOT IN (?" : "IN (?";
+    for (int index = 1; index < count; ++index)
+        expr += ", ?";
+    expr += ")";
+
+    return count;
+}
+
+int QueryImpl::maxParamCount()
+{
+    return 999;
+}
+
+void QueryImpl::bindArray(int /*arg*/, Field::DataType /*itemType*/, const std::vector<std::string>& /*values*/)
+{
+    NGREST_THROW_ASSERT("Array parameters are not supported by this driver");
+}
+
+void QueryImpl::rewind()
+{
+}
+
+void QueryImpl::bindStringRef(int arg, const char* value, std::size_t size, bool /*terminated*/)
+{
+    bindString(arg, std::string(value, size));
+}
+
+void QueryImpl::bindBlob(int arg, const char* data, std::size_t size)
+{
+    bindString(arg, std::string(data, size));
+}
+
+void QueryImpl::bindBlobRef(int arg, const char* data, std::size_t size)
+{
+    bindBlob(arg, data, size);
+}
+
+void QueryImpl::bindBlobStream(int arg, const BlobReader& reader)
+{
+    static const std::size_t chunkSize = 65536;
+    std::string value;
+    std::size_t size = 0;
+    for (;;) {
+        value.resize(size + chunkSize);
+        const std::size_t read = reader(&value[size], chunkSize);
+        if (!read)
+            break;
+        size += read;
+    }
+    bindBlob(arg, value.data(), size);
+}
+
+void QueryImpl::bindIntArray(int arg, const std::vector<int>& values)
+{
+    bindString(arg, toJsonColumn(values));
+}
+
+void QueryImpl::bindStringArray(int arg, const std::vector<std::string>& values)
+{
+    bindString(arg, toJsonColumn(values));
+}
+
+const char* QueryImpl::resultStringRef(int column, std::size_t& length)
+{
+    if (resultRefs.size() <= static_cast<std::size_t>(column))
+        resultRefs.resize(column + 1);
+
+    std::string& value = resultRefs[column];
+    resultString(column, value);
+    length = value.size();
+    return value.c_str();
+}
+
+const char* QueryImpl::resultBlobRef(int column, std::size_t& size)
+{
+    return resultStringRef(column, size);
+}
+
+void QueryImpl::resultIntArray(int column, std::vector<int>& values)
+{
+    std::size_t size = 0;
+    const char* json = resultStringRef(column, size);
+    values.clear();
+    fromJsonColumn(json, size, values);
+}
+
+void QueryImpl::resultStringArray(int column, std::vector<std::string>& values)
+{
+    std::size_t size = 0;
+    const char* json = resultStringRef(column, size);
+    values.clear();
+    fromJsonColumn(json, size, values);
+}
+
+bool QueryImpl::send()
+{
+    return false;
+}
+
+bool QueryImpl::poll()
+{
+    return true;
+}
+
+int QueryImpl::socket()
+{
+    return -1;
+}
+
+std::size_t QueryImpl::bufferSize()
+{
+    return 0;
+}
+
+void QueryImpl::beginBatch()
+{
+}
+
+void QueryImpl::endBatch()
+{
+}
+
 } // namespace ngrest
@@ -21,7 +21,12 @@
 #ifndef NGREST_QUERYIMPL_H
 #define NGREST_QUERYIMPL_H
 
+#include <deque>
+#include <functional>
 #include <string>
+#include <vector>
+
+#include "Field.h"
 
 namespace ngrest {
 
@@ -46,7 +51,57 @@ public:
     virtual void bindFloat(int arg, double value) = 0;
     virtual void bindString(int arg, const std::string& value) = 0;
 
+    //! bind the string without copying it if possible
+    //! the value must stay valid and unchanged until the statement is executed
+    //! or another value is bound to the same arg
+    //! terminated - the value is followed by '\0'
+    virtual void bindStringRef(int arg, const char* value, std::size_t size, bool terminated);
+
+    //! reads the next chunk of binary data into the buffer
+    //! returns the number of bytes read, 0 - no more data
+    typedef std::function<std::size_t(char* buffer, std::size_t size)> BlobReader;
+
+    //! bind the copy of binary data
+    //! default: bind as a string
+    virtual void bindBlob(int arg, const char* data, std::size_t size);
+
+    //! bind binary data without copying it if possible
+    //! the data must stay valid and unchanged until the statement is executed
+    virtual void bindBlobRef(int arg, const char* data, std::size_t size);
+
+    //! bind binary data read by chunks, so large values are not copied in memory twice.
+    //! reader can be called when the statement is executed, so bind it again before
+    //! executing the statement once more.
+    //! default: read the data into one buffer and bind it
+    virtual void bindBlobStream(int arg, const BlobReader& reader);
+
+    //! bind the value of array column
+    //! default: pack the values into JSON array, see JsonColumn.h
+    virtual void bindIntArray(int arg, const std::vector<int>& values);
+    virtual void bindStringArray(int arg, const std::vector<std::string>& values);
+
+    //! build the expression to replace "IN ?" or "NOT IN ?" with, for the list of given size
+    //! returns the number of placeholders for the list items in the expression
+    //! or 0 if the list is bound as one parameter using bindArray
+    //! or -1 if the expression has no parameters.
+    //! default: "IN (?, ?, ...)" with the count of placeholders rounded up to 8, 16, 32... but not above
+    //! maxParamCount() to keep the number of distinct statements small. unused placeholders are bound
+    //! to the last item. empty list is replaced with the empty set, so "IN" matches no rows and
+    //! "NOT IN" matches all rows
+    virtual int expandInList(Field::DataType itemType, std::size_t size, bool negate, std::string& expr);
+
+    //! max number of parameters in one statement
+    //! default: 999, the limit of SQLite before 3.32
+    virtual int maxParamCount();
+
+    //! bind the list of values as one array parameter, values are in text representation
+    virtual void bindArray(int arg, Field::DataType itemType, const std::vector<std::string>& values);
+
     virtual bool next() = 0;
+
+    //! prepare the statement to be executed again with new values bound
+    //! the statement stays prepared, previous result is discarded
+    virtual void rewind();
     virtual bool resultIsNull(int column) = 0;
     virtual bool resultBool(int column) = 0;
     virtual int resultInt(int column) = 0;
@@ -54,7 +109,51 @@ public:
     virtual double resultFloat(int column) = 0;
     virtual void resultString(int column, std::string& value) = 0;
 
+    //! get the string value of the column without copying
+    //! the value is not null terminated and valid until next() or reset()
+    //! default: copy of the value got by resultString, valid until the same column is read again
+    virtual const char* resultStringRef(int column, std::size_t& length);
+
+    //! get the binary value of the column without copying if possible
+    //! the value is valid until next() or reset()
+    //! default: string value
+    virtual const char* resultBlobRef(int column, std::size_t& size);
+
+    //! read the value of array column
+    //! default: unpack the values from JSON array
+    virtual void resultIntArray(int column, std::vector<int>& values);
+    virtual void resultStringArray(int column, std::vector<std::string>& values);
+
     virtual int64_t lastInsertId() = 0;
+
+    // asynchronous execution
+
+    //! start executing the statement without waiting for the result
+    //! returns false if driver can't execute queries asynchronously,
+    //! in that case the statement is executed as usual upon next()
+    virtual bool send();
+
+    //! read the data available on the connection without blocking
+    //! returns true when the result is ready to be read using next()
+    virtual bool poll();
+
+    //! socket to wait for the result on or -1 if not applicable
+    virtual int socket();
+
+    //! memory used by the query for parameters and results in bytes
+    virtual std::size_t bufferSize();
+
+    // batch execution
+
+    //! start sending the statement executions without waiting for each result
+    //! does nothing if driver can't batch the statements
+    virtual void beginBatch();
+
+    //! wait for all the batched executions to finish
+    virtual void endBatch();
+
+private:
+    std::deque<std::string> resultRefs; // values returned by default resultStringRef, growing keeps them in place
 };
 
 } // namespace ngrest
@@ -0,0 +1,220 @@
+/*
+ *  Copyright 2016 Utkin Dmitry <loentar@gmail.com>
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ *  This file is part of ngrest-db: http://github.com/loentar/ngrest-db
+ */
+
+#ifndef _WIN32
+#include <poll.h>
+#include <errno.h>
+#else
+#include <winsock2.h>
+#define poll WSAPoll
+#endif
+
+#include <stdexcept>
+#include <vector>
+
+#include <ngrest/utils/Exception.h>
+
+#include "Db.h"
+#include "Query.h"
+#include "QueryScheduler.h"
+
+namespace ngrest {
+
+struct QueryScheduler::Pending
+{
+    Db* db;
+    Query* query;
+    ResultHandler onResult;
+    ErrorHandler onError;
+    bool ready;
+    std::exception_ptr error;
+};
+
+QueryScheduler::QueryScheduler()
+{
+}
+
+QueryScheduler::~QueryScheduler()
+{
+    for (Pending* item : pending) {
+        delete item->query;
+        delete item;
+    }
+
+    for (const std::pair<Db*, Query*>& item : acquired)
+        delete item.second;
+
+    for (const std::pair<Db*, Query*>& item : idle)
+        delete item.second;
+}
+
+Query& QueryScheduler::query(Db& db)
+{
+    Query* result = nullptr;
+    for (auto it = idle.begin(); it != idle.end(); ++it) {
+        if (it->first == &db) {
+            result = it->second;
+            idle.erase(it);
+            break;
+        }
+    }
+
+    if (!result)
+        result = new Query(db);
+
+    acquired.push_back(std::make_pair(&db, result));
+    return *result;
+}
+
+void QueryScheduler::exec(Query& query, ResultHandler onResult, ErrorHandler onError)
+{
+    auto it = acquired.begin();
+    for (; it != acquired.end(); ++it)
+        if (it->second == &query)
+            break;
+
+    NGREST_ASSERT(it != acquired.end(), "The query is not obtained from this scheduler");
+
+    Db* db = it->first;
+    acquired.erase(it);
+
+    bool sent;
+    try {
+        sent = query.send();
+    } catch (...) {
+        release(db, &query);
+        throw;
+    }
+
+    pending.push_back(new Pending {db, &query, onResult, onError, !sent, std::exception_ptr()});
+}
+
+void QueryScheduler::cancel(Query& query)
+{
+    for (auto it = acquired.begin(); it != acquired.end(); ++it) {
+        if (it->second == &query) {
+            Db* db = it->first;
+            acquired.erase(it);
+            release(db, &query);
+            return;
+        }
+    }
+
+    NGREST_THROW_ASSERT("The query is not obtained from this scheduler");
+}
+
+int QueryScheduler::poll(int timeout)
+{
+    std::list<Pending*> finished;
+
+    auto collect = [&]() {
+        for (auto it = pending.begin(); it != pending.end();) {
+            Pending* item = *it;
+            if (!item->ready) {
+                try {
+                    item->ready = item->query->poll();
+                } catch (...) {
+                    item->error = std::current_exception();
+                    item->ready = true;
+                }
+            }
+
+            if (item->ready) {
+                finished.push_back(item);
+                it = pending.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    };
+
+    collect();
+
+    if (finished.empty() && !pending.empty() && timeout != 0) {
+        std::vector<pollfd> fds;
+        fds.reserve(pending.size());
+        for (Pending* item : pending) {
+            int fd = item->query->socket();
+            if (fd != -1)
+                fds.push_back(pollfd {fd, POLLIN, 0});
+        }
+
+        if (!fds.empty()) {
+            int res = ::poll(fds.data(), fds.size(), timeout);
+#ifndef _WIN32
+            NGREST_ASSERT(res >= 0 || errno == EINTR, "Failed to wait for the results");
+#else
+            NGREST_ASSERT(res >= 0, "Failed to wait for the results");
+#endif
+        }
+
+        collect();
+    }
+
+    // handlers may schedule new queries, so the finished are already removed from pending
+    std::exception_ptr unhandled;
+    for (Pending* item : finished) {
+        try {
+            try {
+                if (item->error)
+                    std::rethrow_exception(item->error);
+                item->onResult(*item->query);
+            } catch (const std::exception& error) {
+                if (!item->onError)
+                    throw;
+                item->onError(error);
+            } catch (...) {
+                if (!item->onError)
+                    throw;
+                item->onError(std::runtime_error("Unknown error"));
+            }
+        } catch (...) {
+            if (!unhandled)
+                unhandled = std::current_exception();
+        }
+
+        release(item->db, item->query);
+        delete item;
+    }
+
+    if (unhandled)
+        std::rethrow_exception(unhandled);
+
+    return static_cast<int>(finished.size());
+}
+
+void QueryScheduler::run()
+{
+    while (!pending.empty())
+        poll(-1);
+}
+
+bool QueryScheduler::isEmpty() const
+{
+    return pending.empty();
+}
+
+void QueryScheduler::release(Db* db, Query* query)
+{
+    query->reset();
+    idle.push_back(std::make_pair(db, query));
+}
+
+} // namespace ngrest
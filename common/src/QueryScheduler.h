@@ -0,0 +1,214 @@
+/*
+ *  Copyright 2016 Utkin Dmitry <loentar@gmail.com>
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ *  This file is part of ngrest-db: http://github.com/loentar/ngrest-db
+ */
+
+#ifndef NGREST_QUERYSCHEDULER_H
+#define NGREST_QUERYSCHEDULER_H
+
+#include <list>
+#include <memory>
+#include <utility>
+#include <exception>
+#include <functional>
+#ifdef __cpp_impl_coroutine
+#include <coroutine>
+#endif
+
+namespace ngrest {
+
+class Db;
+class Query;
+
+//! runs several queries concurrently and calls the handlers when results are ready
+//! each query is executed using it's own connection, connections are reused.
+//! queries of drivers without asynchronous mode are executed upon poll()
+//! not thread safe: use one scheduler per thread
+class QueryScheduler
+{
+public:
+    typedef std::function<void(Query& query)> ResultHandler;
+    typedef std::function<void(const std::exception& error)> ErrorHandler;
+
+    QueryScheduler();
+    ~QueryScheduler();
+
+    //! get an idle query to prepare and bind, it must be passed to exec()
+    Query& query(Db& db);
+
+    //! start executing the query obtained by query()
+    //! if no error handler given the error is thrown from poll()
+    //! error handler is called while handling the exception, so std::current_exception() returns it even if
+    //! it's not derived from std::exception
+    void exec(Query& query, ResultHandler onResult, ErrorHandler onError = ErrorHandler());
+
+    //! return the query obtained by query() without executing it
+    void cancel(Query& query);
+
+    //! wait up to timeout ms for any results and call their handlers
+    //! timeout 0 does not block, -1 waits infinitely
+    //! returns the count of finished queries
+    int poll(int timeout = -1);
+
+    //! wait for all the queries to finish
+    void run();
+
+    bool isEmpty() const;
+
+private:
+    struct Pending;
+
+    QueryScheduler(const QueryScheduler&);
+    QueryScheduler& operator=(const QueryScheduler&);
+
+    void release(Db* db, Query* query);
+
+private:
+    std::list<Pending*> pending;
+    std::list<std::pair<Db*, Query*>> acquired;
+    std::list<std::pair<Db*, Query*>> idle;
+};
+
+#ifdef __cpp_impl_coroutine
+//! result of the query executed by the scheduler, to be used with co_await.
+//! the query is started when the awaitable is created, so several queries can be awaited one by one
+//! while all of them are executed concurrently. the coroutine is resumed from scheduler's poll()
+template <typename Result>
+class QueryAwaitable
+{
+public:
+    typedef std::function<Result(Query& query)> Reader;
+
+    //! start executing the query obtained by scheduler.query()
+    QueryAwaitable(QueryScheduler& scheduler, Query& query, Reader reader):
+        state(std::make_shared<State>())
+    {
+        std::shared_ptr<State> callState = state;
+        scheduler.exec(query, [callState, reader](Query& query) {
+            callState->result = reader(query);
+            callState->complete();
+        }, [callState](const std::exception&) {
+            callState->error = std::current_exception();
+            callState->complete();
+        });
+    }
+
+    bool await_ready() const
+    {
+        return state->isDone;
+    }
+
+    void await_suspend(std::coroutine_handle<> handle)
+    {
+        state->handle = handle;
+    }
+
+    Result await_resume()
+    {
+        if (state->error)
+            std::rethrow_exception(state->error);
+        return std::move(state->result);
+    }
+
+private:
+    struct State
+    {
+        Result result;
+        std::exception_ptr error;
+        bool isDone = false;
+        std::coroutine_handle<> handle;
+
+        void complete()
+        {
+            isDone = true;
+            if (handle)
+                handle.resume();
+        }
+    };
+
+    std::shared_ptr<State> state;
+};
+
+//! coroutine awaiting the queries: QueryTask load(...) { auto users = co_await table.selectAsync(...); }
+//! starts immediately and runs until the first co_await, then continues from scheduler's poll()
+class QueryTask
+{
+public:
+    struct State
+    {
+        bool isDone = false;
+        std::exception_ptr error;
+    };
+
+    struct promise_type
+    {
+        std::shared_ptr<State> state = std::make_shared<State>();
+
+        QueryTask get_return_object()
+        {
+            return QueryTask(state);
+        }
+
+        std::suspend_never initial_suspend() noexcept
+        {
+            return std::suspend_never();
+        }
+
+        std::suspend_never final_suspend() noexcept
+        {
+            return std::suspend_never();
+        }
+
+        void return_void()
+        {
+            state->isDone = true;
+        }
+
+        void unhandled_exception()
+        {
+            state->error = std::current_exception();
+            state->isDone = true;
+        }
+    };
+
+    //! true if the coroutine has finished
+    bool isDone() const
+    {
+        return state->isDone;
+    }
+
+    //! rethrow the exception escaped the coroutine, if any
+    void get() const
+    {
+        if (state->error)
+            std::rethrow_exception(state->error);
+    }
+
+private:
+    explicit QueryTask(const std::shared_ptr<State>& state_):
+        state(state_)
+    {
+    }
+
+    std::shared_ptr<State> state;
+};
+#endif
+
+} // namespace ngrest
+
+#endif // NGREST_QUERYSCHEDULER_H
@@ -0,0 +1,87 @@
+/*
+ *  Copyright 2016 Utkin Dmitry <loentar@gmail.com>
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ *  This file is part of ngrest-db: http://github.com/loentar/ngrest-db
+ */
+
+#include <condition_variable>
+
+#include "SingleFlight.h"
+
+namespace ngrest {
+
+struct SingleFlight::Call
+{
+    std::mutex mutex;
+    std::condition_variable cond;
+    bool isDone = false;
+    std::shared_ptr<void> result;
+    std::exception_ptr error;
+};
+
+SingleFlight::SingleFlight()
+{
+}
+
+SingleFlight::~SingleFlight()
+{
+}
+
+bool SingleFlight::join(const std::string& key, std::shared_ptr<Call>& call)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    std::shared_ptr<Call>& existing = calls[key];
+    if (existing) {
+        call = existing;
+        return false;
+    }
+
+    existing = std::make_shared<Call>();
+    call = existing;
+    return true;
+}
+
+void SingleFlight::complete(const std::string& key, const std::shared_ptr<Call>& call,
+                            const std::shared_ptr<void>& result, std::exception_ptr error)
+{
+    {
+        // callers arriving from now on start a new call
+        std::lock_guard<std::mutex> lock(mutex);
+        calls.erase(key);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(call->mutex);
+        call->result = result;
+        call->error = error;
+        call->isDone = true;
+    }
+    call->cond.notify_all();
+}
+
+const void* SingleFlight::wait(const std::shared_ptr<Call>& call)
+{
+    std::unique_lock<std::mutex> lock(call->mutex);
+    call->cond.wait(lock, [&call] { return call->isDone; });
+
+    if (call->error)
+        std::rethrow_exception(call->error);
+
+    return call->result.get();
+}
+
+} // namespace ngrest
@@ -0,0 +1,173 @@
+/*
+ *  Copyright 2016 Utkin Dmitry <loentar@gmail.com>
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ *  This file is part of ngrest-db: http://github.com/loentar/ngrest-db
+ */
+
+#ifndef NGREST_SINGLEFLIGHT_H
+#define NGREST_SINGLEFLIGHT_H
+
+#include <stdint.h>
+#include <exception>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <typeinfo>
+#include <unordered_map>
+#include <vector>
+
+#include <ngrest/common/Nullable.h>
+#include <ngrest/utils/tostring.h>
+
+namespace ngrest {
+
+//! coalesces identical concurrent calls: the first caller executes the function,
+//! callers with the same key arriving before it finishes wait and get a copy of it's result
+//! or it's exception. thread safe, share one instance between the threads
+class SingleFlight
+{
+public:
+    SingleFlight();
+    ~SingleFlight();
+
+    //! execute the function or wait for the result of the same call in progress
+    template <typename Result, typename Func>
+    Result execute(const std::string& key, Func func)
+    {
+        // different result types must never share the call
+        const std::string callKey = std::string(typeid(Result).name()) + '\0' + key;
+
+        std::shared_ptr<Call> call;
+        if (!join(callKey, call))
+            return *static_cast<const Result*>(wait(call));
+
+        std::shared_ptr<Result> result;
+        try {
+            result = std::make_shared<Result>(func());
+        } catch (...) {
+            complete(callKey, call, std::shared_ptr<void>(), std::current_exception());
+            throw;
+        }
+
+        complete(callKey, call, result, std::exception_ptr());
+        return *result;
+    }
+
+    //! make the key of the query and it's parameters
+    //! source identifies the database the query is executed on, so the same query
+    //! against different databases is never coalesced
+    template <typename... Params>
+    static std::string makeKey(const void* source, const std::string& query, const Params&... params)
+    {
+        std::string key = toString(reinterpret_cast<uintptr_t>(source));
+        key += '\0';
+        key += query;
+        int expand[] = {0, (appendKey(key, params), 0)...};
+        (void) expand;
+        return key;
+    }
+
+private:
+    struct Call;
+
+    SingleFlight(const SingleFlight&);
+    SingleFlight& operator=(const SingleFlight&);
+
+    //! returns true if the caller must execute the call
+    bool join(const std::string& key, std::shared_ptr<Call>& call);
+    void complete(const std::string& key, const std::shared_ptr<Call>& call,
+                  const std::shared_ptr<void>& result, std::exception_ptr error);
+    //! wait for the call to complete and return it's result or rethrow the error
+    const void* wait(const std::shared_ptr<Call>& call);
+
+    static inline void appendKey(std::string& key, std::nullptr_t)
+    {
+        key += '\0';
+        key += 'n';
+    }
+
+    static inline void appendKey(std::string& key, const std::string& value)
+    {
+        // length prefix keeps ("a", "b") and ("a\0sb") apart
+        key += '\0';
+        key += 's';
+        key += toString(value.size());
+        key += ':';
+        key += value;
+    }
+
+    static inline void appendKey(std::string& key, const char* value)
+    {
+        appendKey(key, std::string(value));
+    }
+
+    template <typename T>
+    static inline void appendKey(std::string& key, const Nullable<T>& value)
+    {
+        if (value.isNull()) {
+            appendKey(key, nullptr);
+        } else {
+            appendKey(key, *value);
+        }
+    }
+
+    template <typename T>
+    static inline void appendKey(std::string& key, const std::list<T>& values)
+    {
+        appendItems(key, values);
+    }
+
+    template <typename T>
+    static inline void appendKey(std::string& key, const std::vector<T>& values)
+    {
+        appendItems(key, values);
+    }
+
+    template <typename T>
+    static inline void appendKey(std::string& key, const std::set<T>& values)
+    {
+        appendItems(key, values);
+    }
+
+    template <typename T>
+    static inline void appendKey(std::string& key, const T& value)
+    {
+        key += '\0';
+        key += 'v';
+        key += toString(value);
+    }
+
+    template <typename Container>
+    static void appendItems(std::string& key, const Container& values)
+    {
+        key += '\0';
+        key += 'l';
+        key += toString(values.size());
+        for (const auto& value : values)
+            appendKey(key, value);
+    }
+
+private:
+    std::mutex mutex;
+    std::unordered_map<std::string, std::shared_ptr<Call>> calls;
+};
+
+} // namespace ngrest
+
+#endif // NGREST_SINGLEFLIGHT_H
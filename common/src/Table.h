@@ -26,12 +26,21 @@
 #include <set>
 #include <bitset>
 #include <tuple>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+#include <algorithm>
+#include <functional>
 
 #include <ngrest/utils/Exception.h>
+#include <ngrest/utils/Log.h>
 #include <ngrest/db/Db.h>
 #include <ngrest/db/Field.h>
+#include <ngrest/db/Index.h>
 
 #include "Query.h"
+#include "QueryScheduler.h"
+#include "SingleFlight.h"
 
 // codegenerated file
 #include <tableEntities.h>
@@ -53,6 +62,7 @@ public:
     virtual ~TableBase() {}
     virtual const Entity& getEntity() const = 0;
     virtual void create() = 0;
+    virtual void createIndexes() = 0;
 };
 
 template <typename DataType>
@@ -114,6 +124,41 @@ public:
     void create() override
     {
         query.query(db.getCreateTableQuery(entity));
+        createIndexes();
+    }
+
+    //! create the indexes declared in the entity which are missing in the database
+    void createIndexes() override
+    {
+        const std::list<Index>& indexes = entity.getIndexes();
+        if (indexes.empty())
+            return;
+
+        // unquoted names are case insensitive
+        std::set<std::string> existing;
+        std::string name;
+        query.reset();
+        query.prepare(db.getExistingIndexesQuery(), entity.getTableName());
+        while (query.next()) {
+            query.resultString(0, name);
+            std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+            existing.insert(name);
+        }
+
+        for (const Index& index : indexes) {
+            name = index.name;
+            std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+            if (existing.count(name))
+                continue;
+
+            const std::string& createQuery = db.getCreateIndexQuery(entity, index);
+            if (createQuery.empty())
+                continue;
+
+            LogDebug() << "Creating index: " << index.name;
+            query.reset();
+            query.query(createQuery);
+        }
     }
 
     void setInsertFieldsInclusion(const std::set<std::string>& fields, FieldsInclusion inclusion)
@@ -188,10 +233,9 @@ public:
             query.reset();
             query.prepare("INSERT INTO " + entity.getTableName() + "(" + entity.getFieldsNamesStr() + ") "
                         + "VALUES" + entity.getFieldsArgs());
-            for (const DataType& item : items) {
+            insertBatch(items, [this](const DataType& item) {
                 bindDataToQuery(query, item);
-                query.next();
-            }
+            });
             return *this;
         } else {
             return insert(items, insertFields, insertInclusion);
@@ -212,11 +256,9 @@ public:
 
         query.prepare("INSERT INTO " + entity.getTableName() + "(" + fieldsStr + ") "
                     + "VALUES(" + queryArgs + ")");
-
-        for (const DataType& item : items) {
+        insertBatch(items, [this, &includedFields](const DataType& item) {
             bindDataToQuery(query, item, includedFields);
-            query.next();
-        }
+        });
 
         return *this;
     }
@@ -242,7 +284,7 @@ public:
     {
         std::list<DataType> result;
         query.reset();
-        query.prepare("SELECT " + entity.getFieldsNamesStr() + " FROM " + entity.getTableName());
+        query.prepare("SELECT " + entity.getSelectFieldsNamesStr() + " FROM " + entity.getTableName());
         while (query.next()) {
             result.push_back(DataType());
             readDataFromQuery(query, result.back());
@@ -254,25 +296,27 @@ public:
     template <typename... Params>
     std::list<DataType> select(const std::string& where, const Params... params)
     {
-        query.reset();
-        query.prepare("SELECT " + entity.getFieldsNamesStr() + " FROM " + entity.getTableName() + " WHERE " + where);
-        query.bindAll(params...);
+        const std::string& queryStr = "SELECT " + entity.getSelectFieldsNamesStr() + " FROM " + entity.getTableName()
+                + " WHERE " + where;
 
-        std::list<DataType> result;
-        while (query.next()) {
-            result.push_back(DataType());
-            readDataFromQuery(query, result.back());
-        }
+        return coalesce<std::list<DataType>>(queryStr, [&]() -> std::list<DataType> {
+            query.reset();
+            query.prepare(queryStr, params...);
 
-        return result;
+            std::list<DataType> result;
+            while (query.next()) {
+                result.push_back(DataType());
+                readDataFromQuery(query, result.back());
+            }
+
+            return result;
+        }, params...);
     }
 
     template <typename... Params>
     std::list<DataType> selectFields(const std::set<std::string>& fields, FieldsInclusion inclusion,
                                      const std::string& where, const Params... params)
     {
-        query.reset();
-
         FieldsSet includedFields;
         std::string fieldsStr;
         buildFieldQueryData(fields, inclusion, fieldsStr, includedFields);
@@ -280,16 +324,19 @@ public:
         std::string queryStr = "SELECT " + fieldsStr + " FROM " + entity.getTableName();
         if (!where.empty())
             queryStr += " WHERE " + where;
-        query.prepare(queryStr);
-        query.bindAll(params...);
 
-        std::list<DataType> result;
-        while (query.next()) {
-            result.push_back(DataType());
-            readDataFromQuery(query, result.back(), includedFields);
-        }
+        return coalesce<std::list<DataType>>(queryStr, [&]() -> std::list<DataType> {
+            query.reset();
+            query.prepare(queryStr, params...);
 
-        return result;
+            std::list<DataType> result;
+            while (query.next()) {
+                result.push_back(DataType());
+                readDataFromQuery(query, result.back(), includedFields);
+            }
+
+            return result;
+        }, params...);
     }
 
     // shorthand version
@@ -304,17 +351,19 @@ public:
     template <typename... Params>
     DataType selectOne(const std::string& where, const Params... params)
     {
-        query.reset();
+        const std::string& queryStr = "SELECT " + entity.getSelectFieldsNamesStr() + " FROM " + entity.getTableName()
+                + " WHERE " + where + " LIMIT 1";
 
-        query.prepare("SELECT " + entity.getFieldsNamesStr() + " FROM " + entity.getTableName()
-                      + " WHERE " + where + " LIMIT 1");
-        query.bindAll(params...);
-        NGREST_ASSERT(query.next(), "Error executing query: no more rows");
+        return coalesce<DataType>(queryStr, [&]() -> DataType {
+            query.reset();
+            query.prepare(queryStr, params...);
+            NGREST_ASSERT(query.next(), "Error executing query: no more rows");
 
-        DataType result;
-        readDataFromQuery(query, result);
+            DataType result;
+            readDataFromQuery(query, result);
 
-        return result;
+            return result;
+        }, params...);
     }
 
 
@@ -324,22 +373,23 @@ public:
     std::list<Tuple> selectTuple(const std::list<std::string>& rowNames,
                                  const std::string& where, const Params... params)
     {
-        query.reset();
         std::string queryStr = "SELECT " + join(rowNames) + " FROM " + entity.getTableName();
         if (!where.empty())
             queryStr += " WHERE " + where;
 
-        query.prepare(queryStr);
-        query.bindAll(params...);
+        return coalesce<std::list<Tuple>>(queryStr, [&]() -> std::list<Tuple> {
+            query.reset();
+            query.prepare(queryStr, params...);
 
-        std::list<Tuple> result;
-        Tuple data;
-        while (query.next()) {
-            query.resultAll(data);
-            result.push_back(data);
-        }
+            std::list<Tuple> result;
+            Tuple data;
+            while (query.next()) {
+                query.resultAll(data);
+                result.push_back(data);
+            }
 
-        return result;
+            return result;
+        }, params...);
     }
 
     template<typename Tuple>
@@ -354,45 +404,331 @@ public:
     Tuple selectOneTuple(const std::list<std::string>& rowNames,
             const std::string& where, const Params... params)
     {
-        query.reset();
+        const std::string& queryStr = "SELECT " + join(rowNames) + " FROM " + entity.getTableName()
+                + " WHERE " + where + " LIMIT 1";
 
-        query.prepare("SELECT " + join(rowNames) + " FROM " + entity.getTableName() + " WHERE " + where + " LIMIT 1");
-        query.bindAll(params...);
+        return coalesce<Tuple>(queryStr, [&]() -> Tuple {
+            query.reset();
+            query.prepare(queryStr, params...);
 
-        NGREST_ASSERT(query.next(), "Error executing query: no more rows");
-        Tuple result;
-        query.resultAll(result);
+            NGREST_ASSERT(query.next(), "Error executing query: no more rows");
+            Tuple result;
+            query.resultAll(result);
+
+            return result;
+        }, params...);
+    }
+
+    // select joined
+
+    //! select the items together with the related entities in one query,
+    //! the tables are joined using the foreign keys in any direction.
+    //! the aliases are: t0 for this table, t1, t2, ... for Related in order, e.g.:
+    //! usersToGroups.selectJoined<User, Group>("t1.name LIKE ?", "J%")
+    //! nullable foreign keys are joined using LEFT JOIN, missing items are default initialized
+    template <typename... Related, typename... Params>
+    std::list<std::tuple<DataType, Related...>> selectJoined(const std::string& where, const Params... params)
+    {
+        typedef std::tuple<DataType, Related...> Row;
+
+        const Entity* entities[] = {&entity, &getEntityByDataType<Related>()...};
+        std::string queryStr = getJoinedQuery(entities, sizeof...(Related) + 1);
+        if (!where.empty())
+            queryStr += " WHERE " + where;
+
+        return coalesce<std::list<Row>>(queryStr, [&]() -> std::list<Row> {
+            query.reset();
+            query.prepare(queryStr, params...);
+
+            std::list<Row> result;
+            while (query.next()) {
+                result.push_back(Row());
+                readJoined<0>(result.back(), 0);
+            }
+
+            return result;
+        }, params...);
+    }
+
+    template <typename... Related>
+    std::list<std::tuple<DataType, Related...>> selectJoined()
+    {
+        return selectJoined<Related...>(std::string());
+    }
+
+    // eager loading
+
+    //! load the children of all the parents using chunked "fk IN (...)" queries
+    //! returns the children grouped by parent's primary key, all the parents are present in the result.
+    //! the column is taken from the foreign key to Parent, use fkField if there are several such keys.
+    //! e.g.: usersToGroups.loadFor(users, &UserToGroup::userId)
+    template <typename Parents, typename Key>
+    std::unordered_map<typename PrimaryKey<typename Parents::value_type>::Type, std::list<DataType>>
+    loadFor(const Parents& parents, Key DataType::* fk, const std::string& fkField = std::string(),
+            std::size_t chunkSize = 500)
+    {
+        typedef typename Parents::value_type Parent;
+        typedef typename PrimaryKey<Parent>::Type ParentKey;
+
+        const std::string& column = fkField.empty() ? getForeignKeyField(getEntityByDataType<Parent>()) : fkField;
+
+        std::unordered_map<ParentKey, std::list<DataType>> result;
+        std::vector<ParentKey> keys;
+        keys.reserve(parents.size());
+        for (const Parent& parent : parents) {
+            const ParentKey& key = PrimaryKey<Parent>::get(parent);
+            if (result.insert(std::make_pair(key, std::list<DataType>())).second)
+                keys.push_back(key);
+        }
+
+        NGREST_ASSERT(chunkSize > 0, "Invalid chunk size");
+        for (std::size_t begin = 0; begin < keys.size(); begin += chunkSize) {
+            const std::size_t end = std::min(begin + chunkSize, keys.size());
+            const std::vector<ParentKey> chunk(keys.begin() + begin, keys.begin() + end);
+
+            std::list<DataType> children = select(column + " IN ?", chunk);
+            while (!children.empty()) {
+                auto it = result.find(getKeyValue(children.front().*fk));
+                if (it != result.end()) {
+                    it->second.splice(it->second.end(), children, children.begin());
+                } else {
+                    children.pop_front();
+                }
+            }
+        }
 
         return result;
     }
 
+    // lazy fields
+
+    //! read the lazy field of the item by it's primary key
+    //! field - name of the column, can be omitted if the entity has only one lazy field
+    //! e.g.: articles.fetchLazy(article, &Article::body)
+    template <typename T>
+    void fetchLazy(DataType& item, T DataType::* member, const std::string& field = std::string())
+    {
+        query.reset();
+        query.prepare("SELECT " + getLazyField(field) + " FROM " + entity.getTableName()
+                      + " WHERE " + getPrimaryKeyField() + " = ?", PrimaryKey<DataType>::get(item));
+        NGREST_ASSERT(query.next(), "Error executing query: no more rows");
+        query.result(0, item.*member);
+    }
+
+    //! read the lazy field of all the items using IN queries of up to chunkSize keys each
+    //! e.g.: articles.fetchLazy(articleList, &Article::body)
+    template <typename Items, typename T>
+    void fetchLazy(Items& items, T DataType::* member, const std::string& field = std::string(),
+                   std::size_t chunkSize = 500)
+    {
+        typedef typename PrimaryKey<DataType>::Type Key;
+
+        const std::string& pkField = getPrimaryKeyField();
+        const std::string& queryStr = "SELECT " + pkField + "," + getLazyField(field) + " FROM "
+                + entity.getTableName() + " WHERE " + pkField + " IN ?";
+
+        std::unordered_multimap<Key, DataType*> itemsByKey;
+        std::vector<Key> keys;
+        keys.reserve(items.size());
+        for (DataType& item : items) {
+            const Key& key = PrimaryKey<DataType>::get(item);
+            if (itemsByKey.find(key) == itemsByKey.end())
+                keys.push_back(key);
+            itemsByKey.insert(std::make_pair(key, &item));
+        }
+
+        NGREST_ASSERT(chunkSize > 0, "Invalid chunk size");
+        for (std::size_t begin = 0; begin < keys.size(); begin += chunkSize) {
+            const std::size_t end = std::min(begin + chunkSize, keys.size());
+            const std::vector<Key> chunk(keys.begin() + begin, keys.begin() + end);
+
+            query.reset();
+            query.prepare(queryStr, chunk);
+            Key key = Key();
+            while (query.next()) {
+                query.result(0, key);
+                const auto& range = itemsByKey.equal_range(key);
+                for (auto it = range.first; it != range.second; ++it)
+                    query.result(1, it->second->*member);
+            }
+        }
+    }
+
+    // aggregates
+
+    //! count the rows matching the condition
+    template <typename... Params>
+    int64_t count(const std::string& where, const Params... params)
+    {
+        return aggregate<int64_t>("COUNT(*)", where, params...);
+    }
+
+    int64_t count()
+    {
+        return count(std::string());
+    }
+
+    //! approximate number of rows in the table from the database statistics,
+    //! falls back to count() if the statistics is not available
+    int64_t estimatedCount()
+    {
+        const std::string& queryStr = db.getEstimatedCountQuery(entity.getTableName());
+        if (!queryStr.empty()) {
+            query.reset();
+            query.prepare(queryStr, entity.getTableName());
+            if (query.next() && !query.resultIsNull(0)) {
+                const int64_t result = query.resultBigInt(0);
+                if (result >= 0)
+                    return result;
+            }
+        }
+
+        return count();
+    }
+
+    //! check if there is a row matching the condition, no columns are read
+    template <typename... Params>
+    bool exists(const std::string& where, const Params... params)
+    {
+        std::string queryStr = "SELECT 1 FROM " + entity.getTableName();
+        if (!where.empty())
+            queryStr += " WHERE " + where;
+        queryStr += " LIMIT 1";
+
+        return coalesce<bool>(queryStr, [&]() -> bool {
+            query.reset();
+            query.prepare(queryStr, params...);
+            return query.next();
+        }, params...);
+    }
+
+    //! aggregate functions of the field, e.g.: orders.sum<double>("price", "userId = ?", 1)
+    //! if no rows matched the result is default initialized, use Nullable<T> to get null instead
+    template <typename T, typename... Params>
+    T sum(const std::string& field, const std::string& where, const Params... params)
+    {
+        return aggregate<T>("SUM(" + field + ")", where, params...);
+    }
+
+    template <typename T, typename... Params>
+    T min(const std::string& field, const std::string& where, const Params... params)
+    {
+        return aggregate<T>("MIN(" + field + ")", where, params...);
+    }
+
+    template <typename T, typename... Params>
+    T max(const std::string& field, const std::string& where, const Params... params)
+    {
+        return aggregate<T>("MAX(" + field + ")", where, params...);
+    }
+
+    template <typename T, typename... Params>
+    T avg(const std::string& field, const std::string& where, const Params... params)
+    {
+        return aggregate<T>("AVG(" + field + ")", where, params...);
+    }
+
+    template <typename T>
+    T sum(const std::string& field)
+    {
+        return sum<T>(field, std::string());
+    }
+
+    template <typename T>
+    T min(const std::string& field)
+    {
+        return min<T>(field, std::string());
+    }
+
+    template <typename T>
+    T max(const std::string& field)
+    {
+        return max<T>(field, std::string());
+    }
+
+    template <typename T>
+    T avg(const std::string& field)
+    {
+        return avg<T>(field, std::string());
+    }
+
     template <typename... Params>
     ResultStreamer operator()(const std::string& where, const Params... params)
     {
         query.reset();
-        query.prepare("SELECT " + entity.getFieldsNamesStr() + " FROM " + entity.getTableName() + " WHERE " + where);
-        query.bindAll(params...);
+        query.prepare("SELECT " + entity.getSelectFieldsNamesStr() + " FROM " + entity.getTableName() + " WHERE " + where,
+                      params...);
         return ResultStreamer(*this);
     }
 
     ResultStreamer operator()()
     {
         query.reset();
-        query.prepare("SELECT " + entity.getFieldsNamesStr() + " FROM " + entity.getTableName());
+        query.prepare("SELECT " + entity.getSelectFieldsNamesStr() + " FROM " + entity.getTableName());
         return ResultStreamer(*this);
     }
 
+    // asynchronous select, callback is called from scheduler's poll()
+
+    template <typename... Params>
+    void selectAsync(QueryScheduler& scheduler, std::function<void(const std::list<DataType>&)> callback,
+                     const std::string& where, const Params... params)
+    {
+        Query& asyncQuery = prepareAsync(scheduler, getSelectQuery(where), params...);
+        scheduler.exec(asyncQuery, [callback](Query& query) {
+            callback(readAll(query));
+        });
+    }
+
+    template <typename... Params>
+    void selectOneAsync(QueryScheduler& scheduler, std::function<void(const DataType&)> callback,
+                        const std::string& where, const Params... params)
+    {
+        Query& asyncQuery = prepareAsync(scheduler, getSelectQuery(where) + " LIMIT 1", params...);
+        scheduler.exec(asyncQuery, [callback](Query& query) {
+            callback(readOne(query));
+        });
+    }
+
+#ifdef __cpp_impl_coroutine
+    // asynchronous select for coroutines: co_await table.selectAsync(scheduler, "id > ?", 10)
+
+    template <typename... Params>
+    QueryAwaitable<std::list<DataType>> selectAsync(QueryScheduler& scheduler, const std::string& where,
+                                                    const Params... params)
+    {
+        return QueryAwaitable<std::list<DataType>>(
+                    scheduler, prepareAsync(scheduler, getSelectQuery(where), params...), &Table::readAll);
+    }
+
+    template <typename... Params>
+    QueryAwaitable<DataType> selectOneAsync(QueryScheduler& scheduler, const std::string& where,
+                                            const Params... params)
+    {
+        return QueryAwaitable<DataType>(
+                    scheduler, prepareAsync(scheduler, getSelectQuery(where) + " LIMIT 1", params...),
+                    &Table::readOne);
+    }
+#endif
+
     // delete
 
     template <typename... Params>
     void deleteWhere(const std::string& where, const Params... params)
     {
         query.reset();
-        query.prepare("DELETE FROM " + entity.getTableName() + " WHERE " + where);
-        query.bindAll(params...);
+        query.prepare("DELETE FROM " + entity.getTableName() + " WHERE " + where, params...);
         query.next();
     }
 
+    //! share the results of identical select queries executed concurrently from different threads:
+    //! only the first caller executes the query, the others wait for it and get a copy of the result.
+    //! singleFlight is shared by the tables of all the threads, nullptr - disabled (default)
+    void setSingleFlight(SingleFlight* singleFlight_)
+    {
+        singleFlight = singleFlight_;
+    }
+
     template <typename... Params>
     void deleteAll()
     {
@@ -401,6 +737,35 @@ public:
     }
 
 private:
+    template <typename Result, typename Func, typename... Params>
+    Result coalesce(const std::string& queryStr, Func func, const Params&... params)
+    {
+        if (!singleFlight)
+            return func();
+
+        return singleFlight->execute<Result>(SingleFlight::makeKey(&db, queryStr, params...), func);
+    }
+
+    template <typename Binder>
+    void insertBatch(const std::list<DataType>& items, Binder binder)
+    {
+        query.beginBatch();
+        try {
+            for (const DataType& item : items) {
+                query.rewind();
+                binder(item);
+                query.next();
+            }
+        } catch (...) {
+            try {
+                query.endBatch();
+            } catch (...) {
+            }
+            throw;
+        }
+        query.endBatch();
+    }
+
     void buildFieldQueryData(const std::set<std::string>& fields, FieldsInclusion inclusion,
                              std::string& fieldsStr, FieldsSet& includedFields, std::string* args = nullptr)
     {
@@ -426,6 +791,183 @@ private:
         }
     }
 
+    template <typename... Params>
+    Query& prepareAsync(QueryScheduler& scheduler, const std::string& queryStr, const Params... params)
+    {
+        Query& asyncQuery = scheduler.query(db);
+        try {
+            asyncQuery.prepare(queryStr, params...);
+        } catch (...) {
+            scheduler.cancel(asyncQuery);
+            throw;
+        }
+
+        return asyncQuery;
+    }
+
+    std::string getSelectQuery(const std::string& where) const
+    {
+        std::string queryStr = "SELECT " + entity.getSelectFieldsNamesStr() + " FROM " + entity.getTableName();
+        if (!where.empty())
+            queryStr += " WHERE " + where;
+        return queryStr;
+    }
+
+    static std::list<DataType> readAll(Query& query)
+    {
+        std::list<DataType> result;
+        while (query.next()) {
+            result.push_back(DataType());
+            readDataFromQuery(query, result.back());
+        }
+        return result;
+    }
+
+    static DataType readOne(Query& query)
+    {
+        NGREST_ASSERT(query.next(), "Error executing query: no more rows");
+
+        DataType result;
+        readDataFromQuery(query, result);
+        return result;
+    }
+
+    std::string getJoinedQuery(const Entity* const* entities, int count)
+    {
+        std::string fieldsStr;
+        std::string fromStr = entities[0]->getTableName() + " t0";
+
+        for (int index = 0; index < count; ++index) {
+            const std::string alias = "t" + toString(index);
+            for (const Field& field : entities[index]->getFields()) {
+                if (field.isLazy)
+                    continue;
+                if (!fieldsStr.empty())
+                    fieldsStr += ",";
+                fieldsStr += alias + "." + field.name;
+            }
+
+            if (index > 0)
+                fromStr += getJoin(entities, index, alias);
+        }
+
+        return "SELECT " + fieldsStr + " FROM " + fromStr;
+    }
+
+    //! find the foreign key between the entity and any of already joined entities
+    std::string getJoin(const Entity* const* entities, int index, const std::string& alias)
+    {
+        const Entity* joined = entities[index];
+        const std::string& table = " " + joined->getTableName() + " " + alias + " ON ";
+
+        for (int prev = 0; prev < index; ++prev) {
+            const std::string prevAlias = "t" + toString(prev);
+
+            // prev -> joined
+            for (const Field& field : entities[prev]->getFields()) {
+                if (field.fk && &field.fk->entity == joined) {
+                    return std::string(field.notNull ? " JOIN" : " LEFT JOIN") + table
+                            + prevAlias + "." + field.name + " = " + alias + "." + field.fk->fieldName;
+                }
+            }
+
+            // joined -> prev
+            for (const Field& field : joined->getFields()) {
+                if (field.fk && &field.fk->entity == entities[prev]) {
+                    return " JOIN" + table + alias + "." + field.name + " = " + prevAlias + "." + field.fk->fieldName;
+                }
+            }
+        }
+
+        NGREST_THROW_ASSERT("No foreign key found to join " + joined->getName() + " to " + entity.getName());
+    }
+
+    template <typename T, typename... Params>
+    T aggregate(const std::string& expr, const std::string& where, const Params... params)
+    {
+        std::string queryStr = "SELECT " + expr + " FROM " + entity.getTableName();
+        if (!where.empty())
+            queryStr += " WHERE " + where;
+
+        return coalesce<T>(queryStr, [&]() -> T {
+            query.reset();
+            query.prepare(queryStr, params...);
+
+            T result = T();
+            if (query.next() && !query.resultIsNull(0))
+                query.result(0, result);
+
+            return result;
+        }, params...);
+    }
+
+    //! name of the only field referencing the parent entity
+    std::string getForeignKeyField(const Entity& parent)
+    {
+        std::string result;
+        for (const Field& field : entity.getFields()) {
+            if (field.fk && &field.fk->entity == &parent) {
+                NGREST_ASSERT(result.empty(), "Several foreign keys found from " + entity.getName() + " to "
+                              + parent.getName() + ". Please specify the field name");
+                result = field.name;
+            }
+        }
+
+        NGREST_ASSERT(!result.empty(), "No foreign key found from " + entity.getName() + " to " + parent.getName());
+        return result;
+    }
+
+    std::string getPrimaryKeyField()
+    {
+        for (const Field& field : entity.getFields())
+            if (field.isPK)
+                return field.name;
+
+        NGREST_THROW_ASSERT("No primary key in " + entity.getName());
+    }
+
+    //! the field name given or the only lazy field of the entity
+    std::string getLazyField(const std::string& field)
+    {
+        if (!field.empty())
+            return field;
+
+        std::string result;
+        for (const Field& entityField : entity.getFields()) {
+            if (entityField.isLazy) {
+                NGREST_ASSERT(result.empty(), "Several lazy fields found in " + entity.getName()
+                              + ". Please specify the field name");
+                result = entityField.name;
+            }
+        }
+
+        NGREST_ASSERT(!result.empty(), "No lazy field found in " + entity.getName());
+        return result;
+    }
+
+    template <typename T>
+    inline static const T& getKeyValue(const T& value)
+    {
+        return value;
+    }
+
+    template <typename T>
+    inline static T getKeyValue(const Nullable<T>& value)
+    {
+        return value.isNull() ? T() : *value;
+    }
+
+    template <std::size_t Index, typename Row>
+    inline typename std::enable_if<Index == std::tuple_size<Row>::value>::type readJoined(Row&, int)
+    {
+    }
+
+    template <std::size_t Index, typename Row>
+    inline typename std::enable_if<(Index < std::tuple_size<Row>::value)>::type readJoined(Row& row, int column)
+    {
+        readJoined<Index + 1>(row, readDataFromQuery(query, std::get<Index>(row), column));
+    }
+
     std::string join(const std::list<std::string>& strings)
     {
         std::string::size_type size = 0;
@@ -449,6 +991,7 @@ private:
     const Entity& entity;
     std::set<std::string> insertFields;
     FieldsInclusion insertInclusion = FieldsInclusion::NotSet;
+    SingleFlight* singleFlight = nullptr;
 };
 
 } // namespace ngrest
@@ -19,6 +19,7 @@
  */
 
 #include <set>
+#include <vector>
 #include <algorithm>
 
 #include <mysql/mysql.h>
@@ -29,7 +30,6 @@
 #include <ngrest/utils/tostring.h>
 #include <ngrest/utils/fromcstring.h>
 #include <ngrest/utils/stringutils.h>
-#include <ngrest/utils/MemPool.h>
 #include <ngrest/db/QueryImpl.h>
 #include <ngrest/db/Entity.h>
 #include "MySqlDb.h"
@@ -85,15 +85,29 @@ private:
     MySqlDb* db;
     MYSQL conn;
     int paramCount = 0;
-    MYSQL_BIND* bindParams = nullptr;
+    std::vector<MYSQL_BIND> bindParams;
     MYSQL_STMT* stmt = nullptr;
     int fieldsCount = 0;
     bool isConnected = false;
     bool doExecPrepared = true;
     bool hasResult = false;
-    MYSQL_BIND* result = nullptr;
-    MemPool pool;
-    MemPool poolResult;
+    std::vector<MYSQL_BIND> result;
+
+    // storage for params and results, reused between executions
+    union ParamValue
+    {
+        my_bool boolValue;
+        int intValue;
+        int64_t bigIntValue;
+        double floatValue;
+    };
+    std::vector<ParamValue> paramValues;
+    std::vector<std::string> paramBuffers;
+    std::vector<char> resultBuffer;
+    std::vector<std::string> truncatedBuffers;
+    std::vector<std::string> resultStrings;
+    // readers of the params sent by chunks with mysql_stmt_send_long_data
+    std::vector<std::pair<int, BlobReader>> blobStreams;
 
 public:
     MySqlQueryImpl(MySqlDb* db_):
@@ -132,10 +146,40 @@ public:
             stmt = nullptr;
         }
         fieldsCount = 0;
-        bindParams = nullptr; // don't free(), it's in mempool
-        result = nullptr;
-        pool.reset();
-        poolResult.reset();
+        bindParams.clear();
+        result.clear();
+        blobStreams.clear();
+
+        if (bufferSize() > db->impl->settings.maxBufferSize) {
+            std::vector<MYSQL_BIND>().swap(bindParams);
+            std::vector<MYSQL_BIND>().swap(result);
+            std::vector<ParamValue>().swap(paramValues);
+            std::vector<std::string>().swap(paramBuffers);
+            std::vector<char>().swap(resultBuffer);
+            std::vector<std::string>().swap(resultStrings);
+            std::vector<std::string>().swap(truncatedBuffers);
+        }
+    }
+
+    int maxParamCount() override
+    {
+        // the count of parameters is sent as 2 bytes
+        return 65535;
+    }
+
+    std::size_t bufferSize() override
+    {
+        std::size_t size = (bindParams.capacity() + result.capacity()) * sizeof(MYSQL_BIND)
+                + paramValues.capacity() * sizeof(ParamValue)
+                + paramBuffers.capacity() * sizeof(std::string)
+                + resultBuffer.capacity() + (resultStrings.capacity() + truncatedBuffers.capacity()) * sizeof(std::string);
+        for (const std::string& param : paramBuffers)
+            size += param.capacity();
+        for (const std::string& value : resultStrings)
+            size += value.capacity();
+        for (const std::string& value : truncatedBuffers)
+            size += value.capacity();
+        return size;
     }
 
     void prepare(const std::string& query) override
@@ -178,9 +222,13 @@ public:
                           + "\nQuery was:\n----------\n" + query + "\n----------\n");
 
             paramCount = static_cast<int>(mysql_stmt_param_count(stmt));
+            blobStreams.clear();
 
-            bindParams = reinterpret_cast<MYSQL_BIND*>(pool.grow(sizeof(MYSQL_BIND) * paramCount));
-            memset(bindParams, 0, sizeof(MYSQL_BIND) * paramCount);
+            bindParams.assign(paramCount, MYSQL_BIND());
+            if (paramValues.size() < static_cast<std::size_t>(paramCount)) {
+                paramValues.resize(paramCount);
+                paramBuffers.resize(paramCount);
+            }
 
             doExecPrepared = true;
             hasResult = true;
@@ -197,9 +245,9 @@ public:
     {
         bind->is_null_value = 0;
         bind->is_null = &bind->is_null_value;
-        bind->buffer = pool.grow(sizeof(T));
+        bind->buffer = &paramValues[bind - bindParams.data()];
         *reinterpret_cast<T*>(bind->buffer) = data;
-        bind->buffer_length = sizeof(sizeof(T));
+        bind->buffer_length = sizeof(T);
         bind->length = &bind->buffer_length;
     }
 
@@ -251,12 +299,77 @@ public:
         bind->buffer_type = MYSQL_TYPE_STRING;
         bind->is_null_value = 0;
         bind->is_null = &bind->is_null_value;
-        std::string::size_type size = value.size();
-        bind->buffer = pool.putData(value.data(), size);
+        std::string& param = paramBuffers[arg];
+        param.assign(value);
+        bind->buffer = &param[0];
+        bind->buffer_length = param.size();
+        bind->length = &bind->buffer_length;
+    }
+
+    void bindStringRef(int arg, const char* value, std::size_t size, bool /*terminated*/) override
+    {
+        NGREST_ASSERT(arg < paramCount, "Invalid arg number: " + toString(arg) + " of " + toString(paramCount));
+        MYSQL_BIND* bind = &bindParams[arg];
+        bind->buffer_type = MYSQL_TYPE_STRING;
+        bind->is_null_value = 0;
+        bind->is_null = &bind->is_null_value;
+        bind->buffer = const_cast<char*>(value);
+        bind->buffer_length = size;
+        bind->length = &bind->buffer_length;
+    }
+
+    void bindBlob(int arg, const char* data, std::size_t size) override
+    {
+        NGREST_ASSERT(arg < paramCount, "Invalid arg number: " + toString(arg) + " of " + toString(paramCount));
+        std::string& param = paramBuffers[arg];
+        param.assign(data, size);
+        bindBlobRef(arg, param.data(), param.size());
+    }
+
+    void bindBlobRef(int arg, const char* data, std::size_t size) override
+    {
+        NGREST_ASSERT(arg < paramCount, "Invalid arg number: " + toString(arg) + " of " + toString(paramCount));
+        MYSQL_BIND* bind = &bindParams[arg];
+        bind->buffer_type = MYSQL_TYPE_BLOB;
+        bind->is_null_value = 0;
+        bind->is_null = &bind->is_null_value;
+        bind->buffer = const_cast<char*>(data);
         bind->buffer_length = size;
         bind->length = &bind->buffer_length;
     }
 
+    void bindBlobStream(int arg, const BlobReader& reader) override
+    {
+        NGREST_ASSERT(arg < paramCount, "Invalid arg number: " + toString(arg) + " of " + toString(paramCount));
+        MYSQL_BIND* bind = &bindParams[arg];
+        bind->buffer_type = MYSQL_TYPE_LONG_BLOB;
+        bind->is_null_value = 0;
+        bind->is_null = &bind->is_null_value;
+        bind->buffer = nullptr;
+        bind->buffer_length = 0;
+        bind->length = &bind->buffer_length;
+        // the data is sent right before the execution, after the params are bound
+        blobStreams.emplace_back(arg, reader);
+    }
+
+    void sendBlobStreams()
+    {
+        static const std::size_t chunkSize = 65536;
+        std::string chunk(chunkSize, '\0');
+        for (const std::pair<int, BlobReader>& stream : blobStreams) {
+            for (;;) {
+                const std::size_t read = stream.second(&chunk[0], chunk.size());
+                if (!read)
+                    break;
+                NGREST_ASSERT(!mysql_stmt_send_long_data(stmt, static_cast<unsigned int>(stream.first),
+                                                         chunk.data(), static_cast<unsigned long>(read)),
+                              "Failed to send blob data: \n" + std::string(mysql_stmt_error(stmt)));
+            }
+        }
+        // readers are exhausted, the data must be bound again for the next execution
+        blobStreams.clear();
+    }
+
     bool next() override
     {
         if (!stmt || !hasResult) // no results for exec
@@ -265,9 +378,12 @@ public:
         NGREST_ASSERT(stmt, "No statement prepared. Use prepare() before calling next().");
 
         if (doExecPrepared) {
-            NGREST_ASSERT(mysql_stmt_bind_param(stmt, bindParams) == 0,
+            NGREST_ASSERT(mysql_stmt_bind_param(stmt, bindParams.data()) == 0,
                           "Failed to bind params: \n" + std::string(mysql_stmt_error(stmt)));
 
+            if (!blobStreams.empty())
+                sendBlobStreams();
+
             int status = mysql_stmt_execute(stmt);
             NGREST_ASSERT(status == 0, "Error #" + toString(status) + " executing query: \n"
                           + std::string(mysql_stmt_error(stmt)));
@@ -286,8 +402,7 @@ public:
 
             fieldsCount = static_cast<int>(mysql_stmt_field_count(stmt));
 
-            result = reinterpret_cast<MYSQL_BIND*>(pool.grow(sizeof(MYSQL_BIND) * fieldsCount));
-            memset(result, 0, sizeof(MYSQL_BIND) * fieldsCount);
+            result.assign(fieldsCount, MYSQL_BIND());
 
             prepareResult();
 
@@ -295,11 +410,70 @@ public:
         }
 
         int res = mysql_stmt_fetch(stmt);
+        if (res == MYSQL_DATA_TRUNCATED) {
+            fetchTruncated();
+            res = 0;
+        }
         NGREST_ASSERT(res == 0 || res == MYSQL_NO_DATA, "Error fetching result: \n" + std::string(mysql_stmt_error(stmt)));
 
         return res == 0;
     }
 
+    void fetchTruncated()
+    {
+        // normally should not happen as buffers are sized using max_length
+        if (truncatedBuffers.size() < static_cast<std::size_t>(fieldsCount))
+            truncatedBuffers.resize(fieldsCount);
+
+        for (int column = 0; column < fieldsCount; ++column) {
+            MYSQL_BIND& bind = result[column];
+            if (!bind.error_value)
+                continue;
+
+            // grow the buffer of this column and use it for the rest of rows
+            std::string& buffer = truncatedBuffers[column];
+            buffer.assign(*bind.length + 1, '\0');
+            bind.buffer = &buffer[0];
+            bind.buffer_length = static_cast<unsigned long>(buffer.size());
+            NGREST_ASSERT(!mysql_stmt_fetch_column(stmt, &bind, column, 0),
+                          "Failed to fetch column: " + std::string(mysql_stmt_error(stmt)));
+            bind.error_value = 0;
+        }
+
+        NGREST_ASSERT(!mysql_stmt_bind_result(stmt, result.data()), "Can't bind result: \n"
+                      + std::string(mysql_stmt_error(stmt)));
+    }
+
+    static unsigned long getBufferSize(enum_field_types type, unsigned long maxLength)
+    {
+        switch (type) {
+        case MYSQL_TYPE_TINY:
+            return sizeof(char);
+
+        case MYSQL_TYPE_LONG:
+            return sizeof(int);
+
+        case MYSQL_TYPE_LONGLONG:
+            return sizeof(int64_t);
+
+        case MYSQL_TYPE_DOUBLE:
+            return sizeof(double);
+
+        default:
+            return maxLength + 1; // '\0'
+        }
+    }
+
+    void rewind() override
+    {
+        if (!stmt)
+            return;
+
+        mysql_stmt_free_result(stmt);
+        doExecPrepared = true;
+        hasResult = true;
+    }
+
     enum_field_types getNearestType(enum_field_types type)
     {
         switch (type) {
@@ -310,8 +484,6 @@ public:
 
             // int
         case MYSQL_TYPE_SHORT:
-        case MYSQL_TYPE_DATE:
-        case MYSQL_TYPE_TIME:
         case MYSQL_TYPE_YEAR:
         case MYSQL_TYPE_ENUM:
         case MYSQL_TYPE_LONG:
@@ -320,19 +492,15 @@ public:
             // int64
         case MYSQL_TYPE_LONGLONG:
         case MYSQL_TYPE_INT24:
-        case MYSQL_TYPE_DATETIME:
-        case MYSQL_TYPE_TIMESTAMP:
-        case MYSQL_TYPE_NEWDATE:
             return MYSQL_TYPE_LONGLONG;
 
             // double
-        case MYSQL_TYPE_DECIMAL:
         case MYSQL_TYPE_FLOAT:
         case MYSQL_TYPE_DOUBLE:
-        case MYSQL_TYPE_NEWDECIMAL:
             return MYSQL_TYPE_DOUBLE;
 
-            // fallback to string
+            // fallback to string, including dates and times: "YYYY-MM-DD hh:mm:ss"
+            // and decimals, read as strings to keep the exact value
         default:
             return MYSQL_TYPE_STRING;
         }
@@ -346,33 +514,34 @@ public:
             return;
 
         try {
-            uint64_t totalMaxLen = 0;
-            for (int field = 0; field < fieldsCount; ++field)
-                totalMaxLen += meta->fields[field].max_length;
+            // numeric values are stored aligned
+            const unsigned long align = sizeof(int64_t);
+            uint64_t totalSize = 0;
+            for (int field = 0; field < fieldsCount; ++field) {
+                // make mysql cast type to nearest type of ours supported
+                result[field].buffer_type = getNearestType(meta->fields[field].type);
+                result[field].buffer_length = getBufferSize(result[field].buffer_type, meta->fields[field].max_length);
+                totalSize += (result[field].buffer_length + align - 1) / align * align;
+            }
 
-            poolResult.reset();
-            poolResult.reserve(totalMaxLen);
+            resultBuffer.assign(totalSize, 0);
+            char* data = resultBuffer.data();
 
             for (int field = 0; field < fieldsCount; ++field)
             {
                 // using result provided type, maybe need to convert it for actual result*(column) later
                 // this function is called before result*(column) so we don't know actual types here
 
-                // make mysql cast type to nearest type of ours supported
-                result[field].buffer_type = getNearestType(meta->fields[field].type);
-                result[field].is_null = &result[field].is_null_value;
-
-                unsigned long maxLength = meta->fields[field].max_length;
-                if (maxLength)
-                {
-                    void* data = poolResult.grow(maxLength);
-                    memset(data, 0, maxLength);
-                    result[field].buffer = data;
-                    result[field].buffer_length = maxLength;
-                }
+                // mysql_stmt_fetch writes the values directly into these buffers
+                MYSQL_BIND& bind = result[field];
+                bind.is_null = &bind.is_null_value;
+                bind.length = &bind.length_value;
+                bind.error = &bind.error_value;
+                bind.buffer = data;
+                data += (bind.buffer_length + align - 1) / align * align;
             }
 
-            NGREST_ASSERT(!mysql_stmt_bind_result(stmt, result), "Can't bind result: \n"
+            NGREST_ASSERT(!mysql_stmt_bind_result(stmt, result.data()), "Can't bind result: \n"
                           + std::string(mysql_stmt_error(stmt)));
         } catch(...) {
             mysql_free_result(meta);
@@ -386,9 +555,7 @@ public:
     {
         NGREST_ASSERT(column < fieldsCount, "Invalid column number: " + toString(column) + " of " + toString(fieldsCount));
 
-        NGREST_ASSERT(!mysql_stmt_fetch_column(stmt, &result[column], column, 0),
-                      "Failed to fetch column: " + std::string(mysql_stmt_error(stmt)));
-
+        // already filled by mysql_stmt_fetch
         return result[column];
     }
 
@@ -413,7 +580,7 @@ public:
     {
         switch (res.buffer_type) {
         case MYSQL_TYPE_TINY:
-            return static_cast<T>(castResult<char>(res));
+            return static_cast<T>(castResult<signed char>(res));
 
         case MYSQL_TYPE_LONG:
             return static_cast<T>(castResult<int>(res));
@@ -514,6 +681,24 @@ public:
         }
     }
 
+    const char* resultStringRef(int column, std::size_t& length) override
+    {
+        MYSQL_BIND& res = fetchColumn(column);
+        if (res.buffer_type == MYSQL_TYPE_STRING) {
+            NGREST_ASSERT_NULL(res.length);
+            length = *res.length;
+            return res.buffer ? reinterpret_cast<const char*>(res.buffer) : "";
+        }
+
+        // numbers are converted into the string owned by the query
+        if (resultStrings.size() < static_cast<std::size_t>(fieldsCount))
+            resultStrings.resize(fieldsCount);
+        std::string& value = resultStrings[column];
+        resultString(column, value);
+        length = value.size();
+        return value.c_str();
+    }
+
     int64_t lastInsertId() override
     {
         NGREST_ASSERT(isConnected, "Not Initialized");
@@ -548,7 +733,7 @@ std::string MySqlDb::getCreateTableQuery(const Entity& entity) const
         if (!fieldsStr.empty())
             fieldsStr += ",\n";
         fieldsStr += "  " + field.name + " ";
-        fieldsStr += (!field.dbType.empty() ? field.dbType : getTypeName(field.type)) + " ";
+        fieldsStr += getColumnType(field) + " ";
         if (field.isPK)
             fieldsStr += "PRIMARY KEY ";
         if (field.isAutoincrement)
@@ -558,7 +743,7 @@ std::string MySqlDb::getCreateTableQuery(const Entity& entity) const
         if (field.notNull)
             fieldsStr += "NOT NULL ";
         if (!field.defaultValue.empty()) {
-            if (field.type == Field::DataType::String) {
+            if (field.type == Field::DataType::String || field.type == Field::DataType::Char) {
                 fieldsStr += "DEFAULT '" + field.defaultValue + "'";
             } else {
                 fieldsStr += "DEFAULT " + field.defaultValue;
@@ -573,7 +758,14 @@ std::string MySqlDb::getCreateTableQuery(const Entity& entity) const
         }
     }
 
-    return "CREATE TABLE IF NOT EXISTS " + entity.getTableName() + " (" + fieldsStr + ")";
+    const TableOptions& options = entity.getTableOptions();
+    std::string optionsStr;
+    if (!options.engine.empty())
+        optionsStr += " ENGINE = " + options.engine;
+    if (!options.rowFormat.empty())
+        optionsStr += " ROW_FORMAT = " + options.rowFormat;
+
+    return "CREATE TABLE IF NOT EXISTS " + entity.getTableName() + " (" + fieldsStr + ")" + optionsStr;
 }
 
 const std::string& MySqlDb::getTypeName(Field::DataType type) const
@@ -585,8 +777,19 @@ const std::string& MySqlDb::getTypeName(Field::DataType type) const
         "INTEGER",
         "BIGINT",
         "DOUBLE",
-        "INTEGER",
-        "VARCHAR(255)"
+        "SMALLINT",
+        "VARCHAR(255)",
+        "SMALLINT",
+        "TINYINT",
+        "FLOAT",
+        "CHAR(1)",
+        "DATE",
+        "DATETIME",
+        "DECIMAL(19,4)",
+        "LONGBLOB",
+        "JSON",
+        "JSON", // arrays are packed to JSON
+        "JSON"
     };
 
     const int pos = static_cast<int>(type);
@@ -598,4 +801,39 @@ std::string MySqlDb::getExistingTablesQuery() const
     return "SHOW TABLES";
 }
 
+std::string MySqlDb::getCreateIndexQuery(const Entity& entity, const Index& index) const
+{
+    // gin and other access methods are PostgreSQL specific
+    if (!index.method.empty()) {
+        LogWarning() << "Index method " << index.method << " is not supported, skipping index " << index.name;
+        return std::string();
+    }
+
+    // no INCLUDE: add covering columns to the key unless it breaks uniqueness
+    Index result = index;
+    if (!result.isUnique)
+        result.fields.insert(result.fields.end(), result.include.begin(), result.include.end());
+    result.include.clear();
+
+    // no partial indexes
+    if (!result.where.empty()) {
+        LogWarning() << "Partial indexes are not supported, creating full index " << index.name;
+        result.where.clear();
+    }
+
+    return Db::getCreateIndexQuery(entity, result);
+}
+
+std::string MySqlDb::getExistingIndexesQuery() const
+{
+    return "SELECT DISTINCT INDEX_NAME FROM information_schema.STATISTICS"
+    " WHERE TABLE_SCHEMA = DATABASE() AND TABLE_NAME = ?";
+}
+
+std::string MySqlDb::getEstimatedCountQuery(const std::string& /*table*/) const
+{
+    // exact for MyISAM, estimated for InnoDB
+    return "SELECT TABLE_ROWS FROM information_schema.TABLES WHERE TABLE_SCHEMA = DATABASE() AND TABLE_NAME = ?";
+}
+
 } // namespace ngrest
@@ -32,6 +32,9 @@ struct MySqlDbSettings
     std::string password;
     std::string host;
     unsigned port;
+    //! memory for query parameters and results is reused between executions.
+    //! it's freed on reset() when it's grown larger than this size in bytes
+    std::size_t maxBufferSize = 1024 * 1024;
 
     MySqlDbSettings(const std::string& db_, const std::string& login_, const std::string& password_,
                     const std::string& host_ = "localhost", unsigned port_ = 3306):
@@ -58,6 +61,9 @@ public:
     std::string getCreateTableQuery(const Entity& entity) const override;
     const std::string& getTypeName(Field::DataType type) const override;
     std::string getExistingTablesQuery() const override;
+    std::string getEstimatedCountQuery(const std::string& table) const override;
+    std::string getCreateIndexQuery(const Entity& entity, const Index& index) const override;
+    std::string getExistingIndexesQuery() const override;
 
 private:
     MySqlDb(const MySqlDb&);
@@ -19,7 +19,19 @@
  */
 
 #include <set>
+#include <list>
+#include <vector>
 #include <algorithm>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <poll.h>
+#include <errno.h>
+#else
+#include <winsock2.h>
+#define poll WSAPoll
+#endif
 
 #include <postgresql/libpq-fe.h>
 
@@ -29,13 +41,220 @@
 #include <ngrest/utils/tostring.h>
 #include <ngrest/utils/fromcstring.h>
 #include <ngrest/utils/stringutils.h>
-#include <ngrest/utils/MemPool.h>
 #include <ngrest/db/QueryImpl.h>
+#include <ngrest/db/Query.h>
 #include <ngrest/db/Entity.h>
 #include "PostgresDb.h"
 
 namespace ngrest {
 
+// statements sent in pipeline before reading the results
+static const int pipelineSegmentSize = 512;
+
+static PGconn* connect(const PostgresDbSettings& settings)
+{
+    PGconn* conn = PQsetdbLogin(settings.host.c_str(),
+                                toString(settings.port).c_str(), "", "",
+                                settings.db.c_str(),
+                                settings.login.c_str(),
+                                settings.password.c_str());
+
+    NGREST_ASSERT(conn, std::string("Failed to connect to db: "));
+    if (PQstatus(conn) != CONNECTION_OK) {
+        const std::string& err = std::string("Failed to login: ") + PQerrorMessage(conn);
+        PQfinish(conn);
+        NGREST_THROW_ASSERT(err);
+    }
+
+    int result = PQsetClientEncoding(conn, "UTF8");
+    if (result != 0) {
+        const std::string& err = std::string("error setting encoding: ") + PQerrorMessage(conn);
+        PQfinish(conn);
+        NGREST_THROW_ASSERT(err);
+    }
+
+    return conn;
+}
+
+// binary array format: ndim, has nulls, element type oid, [size, lower bound] per dim, [length, data] per item
+// integers are in network byte order
+static const uint32_t int4Oid = 23;
+static const uint32_t textOid = 25;
+
+static void appendInt32(std::string& buffer, uint32_t value)
+{
+    buffer += static_cast<char>(value >> 24);
+    buffer += static_cast<char>(value >> 16);
+    buffer += static_cast<char>(value >> 8);
+    buffer += static_cast<char>(value);
+}
+
+static void beginBinaryArray(std::string& buffer, uint32_t elementType, std::size_t size)
+{
+    buffer.clear();
+    appendInt32(buffer, size ? 1 : 0); // empty array has no dimensions
+    appendInt32(buffer, 0);
+    appendInt32(buffer, elementType);
+    if (size) {
+        appendInt32(buffer, static_cast<uint32_t>(size));
+        appendInt32(buffer, 1);
+    }
+}
+
+// text array format: {1,2,3} or {abc,"a b","quote \" and \\",NULL}
+static void parseTextArray(const char* pos, const char* end, std::vector<std::string>& values)
+{
+    values.clear();
+    NGREST_ASSERT(pos < end && *pos == '{', "Array value expected");
+    ++pos;
+    std::string item;
+    while (pos < end && *pos != '}') {
+        item.clear();
+        if (*pos == '"') {
+            for (++pos; pos < end && *pos != '"'; ++pos) {
+                if (*pos == '\\' && (pos + 1) < end)
+                    ++pos;
+                item += *pos;
+            }
+            ++pos; // closing quote
+        } else {
+            const char* begin = pos;
+            while (pos < end && *pos != ',' && *pos != '}')
+                ++pos;
+            // unquoted NULL is null item, read as empty string
+            if ((pos - begin) != 4 || strncmp(begin, "NULL", 4))
+                item.assign(begin, pos);
+        }
+        values.push_back(item);
+        if (pos < end && *pos == ',')
+            ++pos;
+    }
+}
+
+// postgres only supports "$1, $2"... as query placeholders
+// we replace "?, ?" it to it. use "\\?" for escaping
+static int translatePlaceholders(const std::string& query, std::string& result)
+{
+    int paramCount = 0;
+    std::string strIndex;
+    result.clear();
+    result.reserve(query.size() + 16);
+
+    const char* start = query.c_str();
+    const char* begin = start;
+    const char* curr = start;
+    for (; *curr; ++curr) {
+        if (*curr == '\'' || *curr == '"') {
+            // "?" inside of quoted literal or identifier is not a placeholder
+            const char* end = strchr(curr + 1, *curr);
+            if (!end) {
+                curr += strlen(curr);
+                break;
+            }
+            curr = end;
+            continue;
+        }
+
+        if (*curr != '?' || (curr != start && *(curr - 1) == '\\')) // skip "\\?"
+            continue;
+
+        result.append(begin, curr - begin);
+        toString(++paramCount, strIndex);
+        result += '$';
+        result += strIndex;
+        begin = curr + 1;
+    }
+    result.append(begin, curr - begin);
+
+    return paramCount;
+}
+
+#ifdef LIBPQ_HAS_PIPELINING
+static void enterPipelineMode(PGconn* conn)
+{
+    // non blocking mode is needed to read the results while sending the queries,
+    // otherwise both client and server may block on writing
+    NGREST_ASSERT(PQenterPipelineMode(conn), "Failed to enter pipeline mode: " + std::string(PQerrorMessage(conn)));
+    NGREST_ASSERT(!PQsetnonblocking(conn, 1), "Failed to set non blocking mode: " + std::string(PQerrorMessage(conn)));
+}
+
+static void exitPipelineMode(PGconn* conn)
+{
+    if (PQsetnonblocking(conn, 0) || !PQexitPipelineMode(conn))
+        LogWarning() << "Failed to exit pipeline mode: " << PQerrorMessage(conn);
+}
+
+static void syncPipeline(PGconn* conn)
+{
+    NGREST_ASSERT(PQpipelineSync(conn), "Failed to sync pipeline: " + std::string(PQerrorMessage(conn)));
+}
+
+static void flushPipeline(PGconn* conn)
+{
+    int res;
+    while ((res = PQflush(conn)) == 1) {
+        pollfd fd = {PQsocket(conn), POLLIN | POLLOUT, 0};
+        int pollRes = ::poll(&fd, 1, -1);
+#ifndef _WIN32
+        NGREST_ASSERT(pollRes >= 0 || errno == EINTR, "Failed to wait for connection");
+#else
+        NGREST_ASSERT(pollRes >= 0, "Failed to wait for connection");
+#endif
+        if (fd.revents & POLLIN)
+            NGREST_ASSERT(PQconsumeInput(conn), "Failed to read: " + std::string(PQerrorMessage(conn)));
+    }
+
+    NGREST_ASSERT(res == 0, "Failed to send the queries: " + std::string(PQerrorMessage(conn)));
+}
+
+//! read the results of the next statement in the pipeline up to the null separator
+//! returns the first result which must be cleared by the caller
+static PGresult* readStatementResult(PGconn* conn)
+{
+    PGresult* result = nullptr;
+    PGresult* res;
+    while ((res = PQgetResult(conn))) {
+        if (result) {
+            PQclear(res);
+        } else {
+            result = res;
+        }
+    }
+
+    return result;
+}
+
+//! skip the results up to the sync point
+static void readPipelineSync(PGconn* conn)
+{
+    int nulls = 0;
+    for (;;) {
+        PGresult* res = PQgetResult(conn);
+        if (!res) {
+            // two nulls in a row mean broken pipeline
+            if (++nulls > 1)
+                break;
+            continue;
+        }
+        nulls = 0;
+
+        ExecStatusType status = PQresultStatus(res);
+        PQclear(res);
+        if (status == PGRES_PIPELINE_SYNC)
+            break;
+    }
+}
+
+//! read the results of the statement followed by sync point
+//! returns the result which must be cleared by the caller
+static PGresult* readPipelineResult(PGconn* conn)
+{
+    PGresult* result = readStatementResult(conn);
+    readPipelineSync(conn);
+    return result;
+}
+#endif
+
 class PostgresDbImpl
 {
 public:
@@ -52,59 +271,90 @@ class PostgresQueryImpl: public QueryImpl
 private:
     PostgresDb* db;
     PGconn* conn;
+    bool ownsConn = true;
+    bool isPipelined = false;
+    bool isBatch = false;
+    int batchCount = 0;
+    std::string queryText;
+    std::string error;
     int paramCount = 0;
     bool doingSelect = false;
     bool doExecPrepared = true;
-    int* paramLengths = nullptr;
-    char** paramValues = nullptr;
-    MemPool pool;
+    bool isPrepared = false;
+    bool isExecuted = false;
+    std::vector<const char*> paramValues;
+    std::vector<int> paramLengths;
+    std::vector<int> paramFormats; // 0 - text, 1 - binary
+    std::vector<std::string> paramBuffers; // reused between executions
+    std::vector<std::string> resultBuffers; // decoded binary values
     PGresult* result = nullptr;
     int currentRow = 0;
     int rowsCount = 0;
     int fieldsCount = 0;
     bool hasResult = false;
+    bool isSent = false;
+    bool isReceived = false;
 
 public:
     PostgresQueryImpl(PostgresDb* db_):
-        db(db_)
+        db(db_),
+        conn(connect(db_->impl->settings))
     {
-        conn = PQsetdbLogin(db->impl->settings.host.c_str(),
-                            toString(db->impl->settings.port).c_str(), "", "",
-                            db->impl->settings.db.c_str(),
-                            db->impl->settings.login.c_str(),
-                            db->impl->settings.password.c_str());
-
-        NGREST_ASSERT(conn, std::string("Failed to connect to db: "));
-        if (PQstatus(conn) != CONNECTION_OK) {
-            const std::string& err = std::string("Failed to login: ") + PQerrorMessage(conn);
-            PQfinish(conn);
-            conn = nullptr;
-            NGREST_THROW_ASSERT(err);
-        }
+    }
 
-        int result = PQsetClientEncoding(conn, "UTF8");
-        NGREST_ASSERT(result == 0, std::string("error setting encoding: ") + PQerrorMessage(conn));
+    //! query of the pipeline, which owns the connection
+    PostgresQueryImpl(PostgresDb* db_, PGconn* conn_):
+        db(db_),
+        conn(conn_),
+        ownsConn(false),
+        isPipelined(true)
+    {
     }
 
     ~PostgresQueryImpl()
     {
         if (conn)
         {
+            if (isBatch) {
+                isBatch = false;
+#ifdef LIBPQ_HAS_PIPELINING
+                exitPipelineMode(conn);
+#endif
+            }
             reset();
-            PQfinish(conn);
+            if (ownsConn)
+                PQfinish(conn);
         }
     }
 
     void reset() override
     {
+        if (isSent)
+        {
+            // connection will be busy until all the results of sent query are read
+            drainResults();
+            isSent = false;
+        }
+        isReceived = false;
+        error.clear();
         if (result)
         {
             PQclear(result);
             result = nullptr;
         }
         fieldsCount = 0;
-        paramLengths = nullptr;
-        paramValues = nullptr;
+        paramCount = 0;
+        paramLengths.clear();
+        paramFormats.clear();
+        paramValues.clear();
+
+        if (bufferSize() > db->impl->settings.maxBufferSize) {
+            std::vector<std::string>().swap(paramBuffers);
+            std::vector<int>().swap(paramLengths);
+            std::vector<int>().swap(paramFormats);
+            std::vector<const char*>().swap(paramValues);
+            std::vector<std::string>().swap(resultBuffers);
+        }
     }
 
     void prepare(const std::string& query) override
@@ -112,36 +362,17 @@ public:
         NGREST_ASSERT(conn, "Not Initialized");
         NGREST_ASSERT(!result, "Already prepared. Use reset() to finalize query.");
 
-        // postgres only supports "$1, $2"... as query placeholders
-        // we replace "?, ?" it to it. use "\\?" for escaping
-
-        std::string fixedQuery = query;
-        std::string strIndex;
-        paramCount = 0;
-        std::string::size_type pos = 0;
-        while ((pos = fixedQuery.find("?", pos)) != std::string::npos)
-        {
-            if (pos > 0 && fixedQuery[pos - 1] == '\\') { // skip "\\?"
-                ++pos;
-                continue;
-            }
-            ++paramCount;
-            toString(paramCount, strIndex);
-            fixedQuery.replace(pos, 1, "$" + strIndex);
-            pos += strIndex.size() + 1;
-        }
-
-        paramLengths = reinterpret_cast<int*>(pool.grow(sizeof(int) * paramCount));
-        paramValues = reinterpret_cast<char**>(pool.grow(sizeof(const char*) * paramCount));
+        paramCount = translatePlaceholders(query, queryText);
 
-        PGresult* res = PQprepare(conn, "", fixedQuery.c_str(), paramCount, nullptr);
+        paramValues.assign(paramCount, nullptr);
+        paramLengths.assign(paramCount, 0);
+        paramFormats.assign(paramCount, 0);
+        if (paramBuffers.size() < static_cast<std::size_t>(paramCount))
+            paramBuffers.resize(paramCount);
 
-        if (PQresultStatus(res) != PGRES_COMMAND_OK) {
-            const std::string& error = "Failed to prepare statement: " + std::string(PQerrorMessage(conn));
-            PQclear(res);
-            NGREST_THROW_ASSERT(error);
-        }
-        PQclear(res);
+        // the statement is prepared on server only when it's executed more than once
+        isPrepared = false;
+        isExecuted = false;
 
         currentRow = 0;
         doExecPrepared = true;
@@ -162,16 +393,16 @@ public:
     {
         NGREST_ASSERT(arg < paramCount, "Invalid arg number: " + toString(arg) + " of " + toString(paramCount));
 
-        char* buffer = pool.grow(NGREST_NUM_TO_STR_BUFF_SIZE);
+        char buffer[NGREST_NUM_TO_STR_BUFF_SIZE];
 
         bool isOk = toCString(value, buffer, NGREST_NUM_TO_STR_BUFF_SIZE);
         NGREST_ASSERT(isOk, "Failed to convert a number to string");
-        const size_t buffLen = strlen(buffer) + 1;
-
-        pool.shrinkLastChunk(NGREST_NUM_TO_STR_BUFF_SIZE - buffLen);
 
-        paramValues[arg] = buffer;
-        paramLengths[arg] = static_cast<int>(buffLen);
+        std::string& param = paramBuffers[arg];
+        param.assign(buffer);
+        paramValues[arg] = param.c_str();
+        paramLengths[arg] = static_cast<int>(param.size() + 1);
+        paramFormats[arg] = 0;
     }
 
     void bindNull(int arg) override
@@ -180,6 +411,7 @@ public:
 
         paramValues[arg] = nullptr;
         paramLengths[arg] = 0;
+        paramFormats[arg] = 0;
     }
 
     void bindBool(int arg, bool value) override
@@ -206,30 +438,189 @@ public:
     {
         NGREST_ASSERT(arg < paramCount, "Invalid arg number: " + toString(arg) + " of " + toString(paramCount));
 
-        const size_t length = value.size() + 1;
-        paramValues[arg] = pool.putCString(value.c_str(), length);
-        paramLengths[arg] = static_cast<int>(length);
+        std::string& param = paramBuffers[arg];
+        param.assign(value);
+        paramValues[arg] = param.c_str();
+        paramLengths[arg] = static_cast<int>(param.size() + 1);
+        paramFormats[arg] = 0;
+    }
+
+    void bindStringRef(int arg, const char* value, std::size_t size, bool terminated) override
+    {
+        NGREST_ASSERT(arg < paramCount, "Invalid arg number: " + toString(arg) + " of " + toString(paramCount));
+
+        // text parameters are read by libpq until '\0'
+        if (terminated) {
+            paramValues[arg] = value;
+        } else {
+            std::string& param = paramBuffers[arg];
+            param.assign(value, size);
+            paramValues[arg] = param.c_str();
+        }
+        paramLengths[arg] = static_cast<int>(size + 1);
+        paramFormats[arg] = 0;
+    }
+
+    int expandInList(Field::DataType itemType, std::size_t /*size*/, bool negate, std::string& expr) override
+    {
+        // the list is bound as one array parameter, so the statement text does not depend on it's size
+        static const int size = static_cast<int>(Field::DataType::Last);
+        static const char* types[size] = {
+            "text",
+            "boolean",
+            "integer",
+            "bigint",
+            "double precision",
+            "integer",
+            "text",
+            "smallint",
+            "smallint",
+            "real",
+            "text",
+            "date",
+            "timestamp",
+            "numeric",
+            "bytea",
+            "jsonb",
+            "integer[]",
+            "text[]"
+        };
+
+        const int pos = static_cast<int>(itemType);
+        expr = negate ? "<> ALL(?::" : "= ANY(?::";
+        expr += (pos >= size || pos <= 0) ? types[0] : types[pos];
+        expr += "[])";
+        return 0;
+    }
+
+    void bindArray(int arg, Field::DataType /*itemType*/, const std::vector<std::string>& values) override
+    {
+        NGREST_ASSERT(arg < paramCount, "Invalid arg number: " + toString(arg) + " of " + toString(paramCount));
+
+        // array literal: {"item1","item2"}
+        std::string& param = paramBuffers[arg];
+        param.assign(1, '{');
+        for (const std::string& value : values) {
+            if (param.size() > 1)
+                param += ',';
+            param += '"';
+            for (char ch : value) {
+                if (ch == '"' || ch == '\\')
+                    param += '\\';
+                param += ch;
+            }
+            param += '"';
+        }
+        param += '}';
+
+        paramValues[arg] = param.c_str();
+        paramLengths[arg] = static_cast<int>(param.size() + 1);
+        paramFormats[arg] = 0;
+    }
+
+    // arrays are sent in binary format, so the items are not escaped
+
+    void bindIntArray(int arg, const std::vector<int>& values) override
+    {
+        NGREST_ASSERT(arg < paramCount, "Invalid arg number: " + toString(arg) + " of " + toString(paramCount));
+
+        std::string& param = paramBuffers[arg];
+        beginBinaryArray(param, int4Oid, values.size());
+        param.reserve(param.size() + values.size() * 8);
+        for (int value : values) {
+            appendInt32(param, 4);
+            appendInt32(param, static_cast<uint32_t>(value));
+        }
+
+        paramValues[arg] = param.data();
+        paramLengths[arg] = static_cast<int>(param.size());
+        paramFormats[arg] = 1;
+    }
+
+    void bindStringArray(int arg, const std::vector<std::string>& values) override
+    {
+        NGREST_ASSERT(arg < paramCount, "Invalid arg number: " + toString(arg) + " of " + toString(paramCount));
+
+        std::string& param = paramBuffers[arg];
+        beginBinaryArray(param, textOid, values.size());
+        for (const std::string& value : values) {
+            appendInt32(param, static_cast<uint32_t>(value.size()));
+            param += value;
+        }
+
+        paramValues[arg] = param.data();
+        paramLengths[arg] = static_cast<int>(param.size());
+        paramFormats[arg] = 1;
+    }
+
+    // binary data is sent in binary format, without escaping
+
+    void bindBlob(int arg, const char* data, std::size_t size) override
+    {
+        NGREST_ASSERT(arg < paramCount, "Invalid arg number: " + toString(arg) + " of " + toString(paramCount));
+
+        std::string& param = paramBuffers[arg];
+        param.assign(data, size);
+        bindBlobRef(arg, param.data(), param.size());
+    }
+
+    void bindBlobRef(int arg, const char* data, std::size_t size) override
+    {
+        NGREST_ASSERT(arg < paramCount, "Invalid arg number: " + toString(arg) + " of " + toString(paramCount));
+
+        paramValues[arg] = data;
+        paramLengths[arg] = static_cast<int>(size);
+        paramFormats[arg] = 1;
+    }
+
+    void bindBlobStream(int arg, const BlobReader& reader) override
+    {
+        NGREST_ASSERT(arg < paramCount, "Invalid arg number: " + toString(arg) + " of " + toString(paramCount));
+
+        static const std::size_t chunkSize = 65536;
+        std::string& param = paramBuffers[arg];
+        std::size_t size = 0;
+        for (;;) {
+            if (param.size() < size + chunkSize)
+                param.resize(std::max(size + chunkSize, param.size() * 2));
+            const std::size_t read = reader(&param[size], param.size() - size);
+            if (!read)
+                break;
+            size += read;
+        }
+        param.resize(size);
+        bindBlobRef(arg, param.data(), param.size());
     }
 
     bool next() override
     {
         NGREST_ASSERT(conn, "Not initialized.");
+        NGREST_ASSERT(error.empty(), error);
 
-        if (doExecPrepared || !doingSelect) {
-            result = PQexecPrepared(conn, "", paramCount, paramValues, paramLengths, nullptr, 0);
+        if (isBatch) {
+            sendBatched();
+            return false;
+        }
 
-            NGREST_ASSERT(result, "Error executing query: \n" + std::string(PQerrorMessage(conn)));
+        if (isSent) {
+            // result is requested before it's ready, wait for it
+            fetchResult();
+        }
 
-            ExecStatusType status = PQresultStatus(result);
-            NGREST_ASSERT(status == PGRES_TUPLES_OK || status == PGRES_COMMAND_OK,
-                          "Failed to execute prepared statement: " + std::string(PQerrorMessage(conn)));
+        if (isReceived) {
+            isReceived = false;
+            return currentRow < rowsCount;
+        }
 
-            hasResult = (status == PGRES_TUPLES_OK);
+        NGREST_ASSERT(!isPipelined, "The pipeline is not flushed yet");
+
+        if (doExecPrepared || !doingSelect) {
+            if (result)
+                PQclear(result);
 
-            rowsCount = PQntuples(result);
-            fieldsCount = PQnfields(result);
+            result = execute();
 
-            doExecPrepared = false;
+            readResult();
 
             return currentRow < rowsCount;
         }
@@ -242,6 +633,18 @@ public:
         return true;
     }
 
+    void rewind() override
+    {
+        if (isSent) {
+            drainResults();
+            isSent = false;
+        }
+        isReceived = false;
+        error.clear();
+        currentRow = 0;
+        doExecPrepared = true;
+    }
+
     bool resultIsNull(int column) override
     {
         NGREST_ASSERT(column < fieldsCount, "Invalid column number: " + toString(column) + " of " + toString(fieldsCount));
@@ -281,11 +684,75 @@ public:
     }
 
     void resultString(int column, std::string& value) override
+    {
+        std::size_t length = 0;
+        const char* valueStr = resultStringRef(column, length);
+        value.assign(valueStr, length);
+    }
+
+    const char* resultStringRef(int column, std::size_t& length) override
     {
         const char* valueStr = PQgetvalue(result, currentRow, column);
         NGREST_ASSERT_NULL(valueStr);
-        int len = PQgetlength(result, currentRow, column);
-        value.assign(valueStr, len);
+        length = static_cast<std::size_t>(PQgetlength(result, currentRow, column));
+        return valueStr;
+    }
+
+    const char* resultBlobRef(int column, std::size_t& size) override
+    {
+        std::size_t length = 0;
+        const char* valueStr = resultStringRef(column, length);
+
+        if (resultBuffers.size() < static_cast<std::size_t>(fieldsCount))
+            resultBuffers.resize(fieldsCount);
+        std::string& value = resultBuffers[column];
+
+        if (length >= 2 && valueStr[0] == '\\' && valueStr[1] == 'x') {
+            // hex output format: \x0102...
+            value.resize((length - 2) / 2);
+            for (std::size_t pos = 0; pos < value.size(); ++pos)
+                value[pos] = static_cast<char>((hexToNum(valueStr[pos * 2 + 2]) << 4) | hexToNum(valueStr[pos * 2 + 3]));
+        } else {
+            // escape output format, used by servers before 9.0 or when bytea_output = escape
+            std::size_t unescapedSize = 0;
+            unsigned char* unescaped = PQunescapeBytea(reinterpret_cast<const unsigned char*>(valueStr), &unescapedSize);
+            NGREST_ASSERT(unescaped, "Failed to unescape binary value");
+            value.assign(reinterpret_cast<const char*>(unescaped), unescapedSize);
+            PQfreemem(unescaped);
+        }
+
+        size = value.size();
+        return value.data();
+    }
+
+    void resultIntArray(int column, std::vector<int>& values) override
+    {
+        std::size_t length = 0;
+        const char* pos = resultStringRef(column, length);
+        const char* end = pos + length;
+
+        values.clear();
+        NGREST_ASSERT(length && *pos == '{', "Array value expected");
+        for (++pos; pos < end && *pos != '}'; ++pos) {
+            char* itemEnd = nullptr;
+            values.push_back(static_cast<int>(strtol(pos, &itemEnd, 10)));
+            NGREST_ASSERT(itemEnd != pos, "Failed to read integer array");
+            pos = itemEnd;
+            if (*pos == '}')
+                break;
+        }
+    }
+
+    void resultStringArray(int column, std::vector<std::string>& values) override
+    {
+        std::size_t length = 0;
+        const char* value = resultStringRef(column, length);
+        parseTextArray(value, value + length, values);
+    }
+
+    static int hexToNum(char ch)
+    {
+        return (ch >= 'a') ? (ch - 'a' + 10) : (ch >= 'A') ? (ch - 'A' + 10) : (ch - '0');
     }
 
     int64_t lastInsertId() override
@@ -297,9 +764,374 @@ public:
         return resultBigInt(0);
     }
 
+    bool send() override
+    {
+        NGREST_ASSERT(conn, "Not initialized.");
+        NGREST_ASSERT(!isSent, "Query is already sent");
+
+        if (result) {
+            PQclear(result);
+            result = nullptr;
+        }
+
+        const int res = isPrepared
+                ? PQsendQueryPrepared(conn, "", paramCount, paramValues.data(), paramLengths.data(), paramFormats.data(), 0)
+                : PQsendQueryParams(conn, queryText.c_str(), paramCount, nullptr,
+                                    paramValues.data(), paramLengths.data(), paramFormats.data(), 0);
+        NGREST_ASSERT(res, "Failed to send query: " + std::string(PQerrorMessage(conn)));
+
+        isSent = true;
+        isReceived = false;
+        return true;
+    }
+
+    bool poll() override
+    {
+        if (!isSent)
+            return true;
+
+        NGREST_ASSERT(PQconsumeInput(conn), "Failed to read the result: " + std::string(PQerrorMessage(conn)));
+
+        // command is complete when PQgetResult returns null
+        while (!PQisBusy(conn)) {
+            PGresult* res = PQgetResult(conn);
+            if (!res) {
+                isSent = false;
+                isReceived = true;
+                readResult();
+                return true;
+            }
+
+            if (result) {
+                PQclear(res);
+            } else {
+                result = res;
+            }
+        }
+
+        return false;
+    }
+
+    int maxParamCount() override
+    {
+        // the count of parameters is sent as 2 bytes
+        return 65535;
+    }
+
+    int socket() override
+    {
+        NGREST_ASSERT(conn, "Not initialized.");
+        return PQsocket(conn);
+    }
+
+    std::size_t bufferSize() override
+    {
+        std::size_t size = paramValues.capacity() * sizeof(const char*)
+                + (paramLengths.capacity() + paramFormats.capacity()) * sizeof(int)
+                + (paramBuffers.capacity() + resultBuffers.capacity()) * sizeof(std::string);
+        for (const std::string& param : paramBuffers)
+            size += param.capacity();
+        for (const std::string& value : resultBuffers)
+            size += value.capacity();
+        return size;
+    }
+
+    void beginBatch() override
+    {
+#ifdef LIBPQ_HAS_PIPELINING
+        NGREST_ASSERT(conn, "Not initialized.");
+        // selects are executed as usual
+        if (doingSelect || isPipelined || isBatch)
+            return;
+
+        NGREST_ASSERT(!isSent, "Query is already sent");
+        enterPipelineMode(conn);
+        isBatch = true;
+        batchCount = 0;
+#endif
+    }
+
+    void endBatch() override
+    {
+#ifdef LIBPQ_HAS_PIPELINING
+        if (!isBatch)
+            return;
+
+        isBatch = false;
+        try {
+            if (batchCount)
+                readBatched();
+        } catch (...) {
+            exitPipelineMode(conn);
+            throw;
+        }
+        exitPipelineMode(conn);
+#endif
+    }
+
+private:
+    friend class PostgresPipeline;
+
+    void drainResults()
+    {
+        PGresult* res;
+        while ((res = PQgetResult(conn))) {
+            if (result) {
+                PQclear(res);
+            } else {
+                result = res;
+            }
+        }
+    }
+
+    PGresult* execute()
+    {
+        if (!isPrepared) {
+            if (!isExecuted) {
+                // first execution: parse, bind and execute in one round trip
+                isExecuted = true;
+                return PQexecParams(conn, queryText.c_str(), paramCount, nullptr,
+                                    paramValues.data(), paramLengths.data(), paramFormats.data(), 0);
+            }
+
+            // the statement is reused
+            prepareStatement();
+        }
+
+        return PQexecPrepared(conn, "", paramCount, paramValues.data(), paramLengths.data(), paramFormats.data(), 0);
+    }
+
+    void prepareStatement()
+    {
+        PGresult* res = PQprepare(conn, "", queryText.c_str(), paramCount, nullptr);
+
+        if (PQresultStatus(res) != PGRES_COMMAND_OK) {
+            const std::string& error = "Failed to prepare statement: " + std::string(PQerrorMessage(conn));
+            PQclear(res);
+            NGREST_THROW_ASSERT(error);
+        }
+        PQclear(res);
+        isPrepared = true;
+    }
+
+    void fetchResult()
+    {
+        drainResults();
+        isSent = false;
+        isReceived = true;
+        readResult();
+    }
+
+    void readResult()
+    {
+        NGREST_ASSERT(result, "Error executing query: \n" + std::string(PQerrorMessage(conn)));
+
+        ExecStatusType status = PQresultStatus(result);
+        NGREST_ASSERT(status == PGRES_TUPLES_OK || status == PGRES_COMMAND_OK,
+                      "Failed to execute prepared statement: " + std::string(PQresultErrorMessage(result)));
+
+        hasResult = (status == PGRES_TUPLES_OK);
+
+        rowsCount = PQntuples(result);
+        fieldsCount = PQnfields(result);
+        currentRow = 0;
+
+        doExecPrepared = false;
+    }
+
+#ifdef LIBPQ_HAS_PIPELINING
+    void sendBatched()
+    {
+        if (!isPrepared) {
+            // preparing is pipelined too, it's result is read along with the statements
+            NGREST_ASSERT(PQsendPrepare(conn, "", queryText.c_str(), paramCount, nullptr),
+                          "Failed to prepare statement: " + std::string(PQerrorMessage(conn)));
+            isPrepared = true;
+            ++batchCount;
+        }
+
+        NGREST_ASSERT(PQsendQueryPrepared(conn, "", paramCount, paramValues.data(), paramLengths.data(), paramFormats.data(), 0),
+                      "Failed to send query: " + std::string(PQerrorMessage(conn)));
+
+        if (++batchCount == pipelineSegmentSize)
+            readBatched();
+    }
+
+    void readBatched()
+    {
+        // all statements up to the sync point are executed in one implicit transaction
+        syncPipeline(conn);
+        flushPipeline(conn);
+
+        // the statements after the failed one are reported as aborted, so the first error is the cause
+        std::string firstError;
+        for (; batchCount > 0; --batchCount) {
+            PGresult* res = readStatementResult(conn);
+            ExecStatusType status = res ? PQresultStatus(res) : PGRES_FATAL_ERROR;
+            if (status != PGRES_COMMAND_OK && status != PGRES_TUPLES_OK && firstError.empty())
+                firstError = res ? PQresultErrorMessage(res) : PQerrorMessage(conn);
+            PQclear(res);
+        }
+        readPipelineSync(conn);
+
+        if (!firstError.empty()) {
+            // the statement could fail to prepare
+            isPrepared = false;
+            NGREST_THROW_ASSERT("Failed to execute batched statement: " + firstError);
+        }
+    }
+#else
+    void sendBatched()
+    {
+    }
+#endif
+
+    void sendPipelined()
+    {
+        NGREST_ASSERT(PQsendQueryParams(conn, queryText.c_str(), paramCount, nullptr,
+                                        paramValues.data(), paramLengths.data(), paramFormats.data(), 0),
+                      "Failed to send query: " + std::string(PQerrorMessage(conn)));
+        isSent = true;
+    }
+
+    void setPipelineResult(PGresult* res)
+    {
+        isSent = false;
+        isReceived = true;
+        result = res;
+        try {
+            readResult();
+        } catch (const std::exception& err) {
+            error = err.what();
+        }
+    }
+
 };
 
 
+class PostgresPipelineImpl
+{
+public:
+    PostgresDb* db;
+    PGconn* conn = nullptr;
+    std::list<Query*> queries;
+    std::list<PostgresQueryImpl*> pending;
+
+    PostgresPipelineImpl(PostgresDb* db_):
+        db(db_)
+    {
+    }
+};
+
+
+PostgresPipeline::PostgresPipeline(PostgresDb& db):
+    impl(new PostgresPipelineImpl(&db))
+{
+    try {
+        impl->conn = connect(db.impl->settings);
+    } catch (...) {
+        delete impl;
+        throw;
+    }
+}
+
+PostgresPipeline::~PostgresPipeline()
+{
+    clear();
+    PQfinish(impl->conn);
+    delete impl;
+}
+
+Query& PostgresPipeline::add(const std::string& query)
+{
+    PostgresQueryImpl* queryImpl = new PostgresQueryImpl(impl->db, impl->conn);
+    Query* result = new Query(queryImpl);
+    try {
+        result->prepare(query);
+    } catch (...) {
+        delete result;
+        throw;
+    }
+
+    impl->queries.push_back(result);
+    impl->pending.push_back(queryImpl);
+    return *result;
+}
+
+void PostgresPipeline::flush()
+{
+    std::list<PostgresQueryImpl*> pending;
+    pending.swap(impl->pending);
+
+    PGconn* conn = impl->conn;
+    std::string firstError;
+
+    try {
+#ifdef LIBPQ_HAS_PIPELINING
+        enterPipelineMode(conn);
+        try {
+            auto it = pending.begin();
+            while (it != pending.end()) {
+                // each statement is followed by sync to execute it in it's own transaction
+                auto segment = it;
+                for (int count = 0; it != pending.end() && count < pipelineSegmentSize; ++it, ++count) {
+                    (*it)->sendPipelined();
+                    syncPipeline(conn);
+                }
+                flushPipeline(conn);
+
+                for (; segment != it; ++segment) {
+                    PostgresQueryImpl* query = *segment;
+                    query->setPipelineResult(readPipelineResult(conn));
+                    if (!query->error.empty() && firstError.empty())
+                        firstError = query->error;
+                }
+            }
+        } catch (...) {
+            exitPipelineMode(conn);
+            throw;
+        }
+        exitPipelineMode(conn);
+#else
+        for (PostgresQueryImpl* query : pending) {
+            query->sendPipelined();
+            PGresult* result = nullptr;
+            PGresult* res;
+            while ((res = PQgetResult(conn))) {
+                if (result) {
+                    PQclear(res);
+                } else {
+                    result = res;
+                }
+            }
+            query->setPipelineResult(result);
+            if (!query->error.empty() && firstError.empty())
+                firstError = query->error;
+        }
+#endif
+    } catch (const std::exception& err) {
+        // the results of the statements not received will never come
+        for (PostgresQueryImpl* query : pending) {
+            if (!query->isReceived) {
+                query->isSent = false;
+                query->error = err.what();
+            }
+        }
+        throw;
+    }
+
+    NGREST_ASSERT(firstError.empty(), firstError);
+}
+
+void PostgresPipeline::clear()
+{
+    for (Query* query : impl->queries)
+        delete query;
+    impl->queries.clear();
+    impl->pending.clear();
+}
+
+
 PostgresDb::PostgresDb(const PostgresDbSettings& settings):
     impl(new PostgresDbImpl(settings))
 {
@@ -325,14 +1157,10 @@ std::string PostgresDb::getCreateTableQuery(const Entity& entity) const
             fieldsStr += ",\n";
         fieldsStr += "  " + field.name + " ";
 
-        if (field.dbType.empty()) {
-            if (field.isAutoincrement) {
-                fieldsStr += "SERIAL ";
-            } else {
-                fieldsStr += getTypeName(field.type) + " ";
-            }
+        if (field.dbType.empty() && field.isAutoincrement) {
+            fieldsStr += field.type == Field::DataType::BigInt ? "BIGSERIAL " : "SERIAL ";
         } else {
-            fieldsStr += field.dbType + " ";
+            fieldsStr += getColumnType(field) + " ";
         }
         if (field.isPK)
             fieldsStr += "PRIMARY KEY ";
@@ -341,7 +1169,7 @@ std::string PostgresDb::getCreateTableQuery(const Entity& entity) const
         if (field.notNull)
             fieldsStr += "NOT NULL ";
         if (!field.defaultValue.empty()) {
-            if (field.type == Field::DataType::String) {
+            if (field.type == Field::DataType::String || field.type == Field::DataType::Char) {
                 fieldsStr += "DEFAULT '" + field.defaultValue + "'";
             } else {
                 fieldsStr += "DEFAULT " + field.defaultValue;
@@ -356,7 +1184,13 @@ std::string PostgresDb::getCreateTableQuery(const Entity& entity) const
         }
     }
 
-    return "CREATE TABLE IF NOT EXISTS " + entity.getTableName() + " (" + fieldsStr + ")";
+    const TableOptions& options = entity.getTableOptions();
+    std::string optionsStr;
+    if (options.fillFactor > 0)
+        optionsStr += " WITH (fillfactor = " + toString(options.fillFactor) + ")";
+
+    return std::string(options.unlogged ? "CREATE UNLOGGED TABLE" : "CREATE TABLE")
+            + " IF NOT EXISTS " + entity.getTableName() + " (" + fieldsStr + ")" + optionsStr;
 }
 
 const std::string& PostgresDb::getTypeName(Field::DataType type) const
@@ -368,8 +1202,19 @@ const std::string& PostgresDb::getTypeName(Field::DataType type) const
         "INTEGER",
         "BIGINT",
         "DOUBLE PRECISION",
-        "INTEGER",
-        "VARCHAR(256)"
+        "SMALLINT",
+        "VARCHAR(256)",
+        "SMALLINT",
+        "SMALLINT", // no single byte integer in PostgreSQL
+        "REAL",
+        "CHAR(1)",
+        "DATE",
+        "TIMESTAMP",
+        "NUMERIC",
+        "BYTEA",
+        "JSONB",
+        "INTEGER[]",
+        "TEXT[]"
     };
 
     const int pos = static_cast<int>(type);
@@ -383,4 +1228,18 @@ std::string PostgresDb::getExistingTablesQuery() const
     " ORDER BY table_name";
 }
 
+std::string PostgresDb::getExistingIndexesQuery() const
+{
+    return "SELECT indexname FROM pg_indexes WHERE schemaname = 'public' AND tablename = ?";
+}
+
+std::string PostgresDb::getEstimatedCountQuery(const std::string& /*table*/) const
+{
+    // same as planner does: tuples density from the last ANALYZE multiplied by the current size in pages.
+    // reltuples is -1 (PostgreSQL 14+) or relpages is 0 if the table was never analyzed
+    return "SELECT CASE WHEN reltuples < 0 OR relpages = 0 THEN -1"
+    " ELSE (reltuples / relpages * (pg_relation_size(oid) / current_setting('block_size')::integer))::bigint END"
+    " FROM pg_class WHERE oid = to_regclass(?)";
+}
+
 } // namespace ngrest
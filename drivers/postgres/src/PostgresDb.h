@@ -32,6 +32,9 @@ struct PostgresDbSettings
     std::string password;
     std::string host;
     unsigned port;
+    //! memory for query parameters is reused between executions.
+    //! it's freed on reset() when it's grown larger than this size in bytes
+    std::size_t maxBufferSize = 1024 * 1024;
 
     PostgresDbSettings(const std::string& db_, const std::string& login_, const std::string& password_,
                     const std::string& host_ = "localhost", unsigned port_ = 5432):
@@ -46,6 +49,9 @@ struct PostgresDbSettings
 
 class PostgresDbImpl;
 class PostgresQueryImpl;
+class PostgresPipeline;
+class PostgresPipelineImpl;
+class Query;
 
 class PostgresDb: public Db
 {
@@ -58,12 +64,41 @@ public:
     std::string getCreateTableQuery(const Entity& entity) const override;
     const std::string& getTypeName(Field::DataType type) const override;
     std::string getExistingTablesQuery() const override;
+    std::string getEstimatedCountQuery(const std::string& table) const override;
+    std::string getExistingIndexesQuery() const override;
 
 private:
     PostgresDb(const PostgresDb&);
     PostgresDb& operator=(const PostgresDb&);
     PostgresDbImpl* impl;
     friend class PostgresQueryImpl;
+    friend class PostgresPipeline;
+};
+
+//! sends several independent statements to the server in one round trip
+//! uses own connection. with libpq older than 14 the statements are executed one by one
+class PostgresPipeline
+{
+public:
+    PostgresPipeline(PostgresDb& db);
+    ~PostgresPipeline();
+
+    //! add the statement to the pipeline
+    //! returned query is used to bind the parameters and to read the result after flush()
+    Query& add(const std::string& query);
+
+    //! send all the statements added since last flush and read their results
+    //! each statement is executed in it's own transaction.
+    //! after all the results are read the error of first failed statement is thrown
+    void flush();
+
+    //! remove all the statements
+    void clear();
+
+private:
+    PostgresPipeline(const PostgresPipeline&);
+    PostgresPipeline& operator=(const PostgresPipeline&);
+    PostgresPipelineImpl* impl;
 };
 
 } // namespace ngrest
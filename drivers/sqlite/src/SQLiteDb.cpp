@@ -18,6 +18,17 @@
  *  This file is part of ngrest-db: http://github.com/loentar/ngrest-db
  */
 
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <future>
+#include <condition_variable>
+#include <algorithm>
+
 #include <sqlite3.h>
 
 #include <ngrest/utils/Exception.h>
@@ -30,19 +41,424 @@
 
 namespace ngrest {
 
+//! statement to execute by the writer thread
+struct WriteRequest
+{
+    sqlite3_stmt* stmt;
+    std::atomic<WriteRequest*> next;
+    int status = SQLITE_OK;
+    std::string error;
+    int64_t insertId = 0;
+    std::promise<void> done;
+
+    WriteRequest(sqlite3_stmt* stmt_ = nullptr):
+        stmt(stmt_),
+        next(nullptr)
+    {
+    }
+};
+
+//! intrusive lock-free multiple producers single consumer queue (Dmitry Vyukov's algorithm)
+class WriteQueue
+{
+public:
+    WriteQueue():
+        head(&stub),
+        tail(&stub)
+    {
+    }
+
+    //! called from any thread
+    void push(WriteRequest* request)
+    {
+        request->next.store(nullptr, std::memory_order_relaxed);
+        WriteRequest* prev = head.exchange(request);
+        // until this store the queue is inconsistent: pop() returns nullptr while it's not empty
+        prev->next.store(request, std::memory_order_release);
+    }
+
+    //! called from consumer thread only
+    WriteRequest* pop()
+    {
+        WriteRequest* curr = tail;
+        WriteRequest* next = curr->next.load(std::memory_order_acquire);
+        if (curr == &stub) {
+            if (!next)
+                return nullptr;
+            tail = next;
+            curr = next;
+            next = next->next.load(std::memory_order_acquire);
+        }
+
+        if (next) {
+            tail = next;
+            return curr;
+        }
+
+        if (curr != head.load(std::memory_order_acquire))
+            return nullptr; // push is in progress
+
+        push(&stub);
+
+        next = curr->next.load(std::memory_order_acquire);
+        if (next) {
+            tail = next;
+            return curr;
+        }
+
+        return nullptr;
+    }
+
+    //! called from consumer thread only
+    bool isEmpty() const
+    {
+        return tail == head.load() && !tail->next.load();
+    }
+
+private:
+    std::atomic<WriteRequest*> head;
+    WriteRequest* tail;
+    WriteRequest stub;
+};
+
+class SQLiteWriter
+{
+public:
+    SQLiteWriter(sqlite3* conn_, int batchSize_):
+        conn(conn_),
+        batchSize(batchSize_ > 0 ? batchSize_ : 1)
+    {
+        thread = std::thread(&SQLiteWriter::run, this);
+    }
+
+    ~SQLiteWriter()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            isStopping = true;
+        }
+        cond.notify_one();
+        thread.join();
+    }
+
+    //! execute the statement in the writer thread and wait for commit
+    void exec(WriteRequest& request)
+    {
+        std::future<void> done = request.done.get_future();
+        queue.push(&request);
+        if (isSleeping.load()) {
+            { std::lock_guard<std::mutex> lock(mutex); }
+            cond.notify_one();
+        }
+        done.wait();
+    }
+
+private:
+    void run()
+    {
+        std::vector<WriteRequest*> batch;
+        batch.reserve(batchSize);
+
+        for (;;) {
+            WriteRequest* request = queue.pop();
+            if (!request) {
+                if (!queue.isEmpty()) {
+                    // producer is in the middle of push
+                    std::this_thread::yield();
+                    continue;
+                }
+
+                std::unique_lock<std::mutex> lock(mutex);
+                if (isStopping)
+                    break;
+                isSleeping.store(true);
+                cond.wait(lock, [this] { return isStopping || !queue.isEmpty(); });
+                isSleeping.store(false);
+                continue;
+            }
+
+            batch.push_back(request);
+            while (static_cast<int>(batch.size()) < batchSize && (request = queue.pop()))
+                batch.push_back(request);
+
+            commit(batch);
+            batch.clear();
+        }
+    }
+
+    void commit(const std::vector<WriteRequest*>& batch)
+    {
+        std::string error;
+        if (sqlite3_exec(conn, "BEGIN IMMEDIATE", nullptr, nullptr, nullptr) != SQLITE_OK)
+            error = std::string("Failed to begin transaction: ") + sqlite3_errmsg(conn);
+
+        if (error.empty()) {
+            for (WriteRequest* request : batch) {
+                // savepoint allows to roll back failed statement only
+                sqlite3_exec(conn, "SAVEPOINT request", nullptr, nullptr, nullptr);
+
+                int status;
+                while ((status = sqlite3_step(request->stmt)) == SQLITE_ROW); // rows are discarded
+
+                if (status == SQLITE_DONE) {
+                    request->insertId = sqlite3_last_insert_rowid(conn);
+                    sqlite3_exec(conn, "RELEASE request", nullptr, nullptr, nullptr);
+                } else {
+                    request->status = status;
+                    request->error = sqlite3_errmsg(conn);
+                    sqlite3_exec(conn, "ROLLBACK TO request", nullptr, nullptr, nullptr);
+                    sqlite3_exec(conn, "RELEASE request", nullptr, nullptr, nullptr);
+                }
+                sqlite3_reset(request->stmt);
+            }
+
+            int status = sqlite3_exec(conn, "COMMIT", nullptr, nullptr, nullptr);
+            if (status != SQLITE_OK) {
+                error = std::string("Failed to commit: ") + sqlite3_errmsg(conn);
+                sqlite3_exec(conn, "ROLLBACK", nullptr, nullptr, nullptr);
+            }
+        }
+
+        for (WriteRequest* request : batch) {
+            if (!error.empty() && request->status == SQLITE_OK) {
+                request->status = SQLITE_ERROR;
+                request->error = error;
+            }
+            request->done.set_value();
+        }
+    }
+
+private:
+    sqlite3* conn;
+    int batchSize;
+    WriteQueue queue;
+    std::mutex mutex;
+    std::condition_variable cond;
+    std::atomic<bool> isSleeping {false};
+    bool isStopping = false;
+    std::thread thread;
+};
+
+//! copies in-memory database to a file
+class SQLiteSnapshotter
+{
+public:
+    SQLiteSnapshotter(sqlite3* conn_, const SQLiteDbSettings& settings):
+        conn(conn_),
+        path(settings.snapshotPath),
+        interval(settings.snapshotInterval),
+        pagesPerStep(settings.snapshotPagesPerStep > 0 ? settings.snapshotPagesPerStep : -1)
+    {
+        if (interval > 0)
+            thread = std::thread(&SQLiteSnapshotter::run, this);
+    }
+
+    ~SQLiteSnapshotter()
+    {
+        if (thread.joinable()) {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                isStopping = true;
+            }
+            cond.notify_one();
+            thread.join();
+        }
+    }
+
+    //! load last snapshot into the database
+    static void restore(sqlite3* conn, const std::string& path)
+    {
+        if (!File(path).isFile())
+            return;
+
+        sqlite3* file = nullptr;
+        int result = sqlite3_open_v2(path.c_str(), &file, SQLITE_OPEN_READONLY, nullptr);
+        if (result == SQLITE_OK) {
+            sqlite3_backup* backup = sqlite3_backup_init(conn, "main", file, "main");
+            if (backup) {
+                sqlite3_backup_step(backup, -1);
+                result = sqlite3_backup_finish(backup);
+            } else {
+                result = sqlite3_errcode(conn);
+            }
+        }
+
+        const std::string error = (result != SQLITE_OK) ? sqlite3_errstr(result) : "";
+        sqlite3_close(file);
+        NGREST_ASSERT(error.empty(), "Failed to restore database from snapshot \"" + path + "\": " + error);
+    }
+
+    //! write the snapshot to temporary file and replace the previous one with it
+    void snapshot(bool incremental)
+    {
+        std::lock_guard<std::mutex> lock(snapshotMutex);
+
+        const std::string tmpPath = path + ".tmp";
+        sqlite3* file = nullptr;
+        int result = sqlite3_open(tmpPath.c_str(), &file);
+        if (result == SQLITE_OK) {
+            sqlite3_backup* backup = sqlite3_backup_init(file, "main", conn, "main");
+            if (backup) {
+                for (;;) {
+                    result = sqlite3_backup_step(backup, incremental ? pagesPerStep : -1);
+                    if (result == SQLITE_DONE)
+                        break;
+                    if (result != SQLITE_OK && result != SQLITE_BUSY && result != SQLITE_LOCKED)
+                        break;
+                    // let the writers work
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                }
+                sqlite3_backup_finish(backup);
+                if (result == SQLITE_DONE)
+                    result = SQLITE_OK;
+            } else {
+                result = sqlite3_errcode(file);
+            }
+        }
+        sqlite3_close(file);
+
+        if (result == SQLITE_OK) {
+#ifdef _WIN32
+            std::remove(path.c_str());
+#endif
+            NGREST_ASSERT(std::rename(tmpPath.c_str(), path.c_str()) == 0,
+                          "Failed to replace snapshot \"" + path + "\"");
+        } else {
+            std::remove(tmpPath.c_str());
+            NGREST_THROW_ASSERT("Failed to write snapshot \"" + path + "\": " + sqlite3_errstr(result));
+        }
+    }
+
+private:
+    void run()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (!cond.wait_for(lock, std::chrono::milliseconds(interval), [this] { return isStopping; })) {
+            lock.unlock();
+            try {
+                snapshot(true);
+            } catch (const std::exception& err) {
+                LogWarning() << err.what();
+            }
+            lock.lock();
+        }
+    }
+
+private:
+    sqlite3* conn;
+    std::string path;
+    int interval;
+    int pagesPerStep;
+    std::mutex mutex;
+    std::mutex snapshotMutex;
+    std::condition_variable cond;
+    bool isStopping = false;
+    std::thread thread;
+};
+
+// empty path is not in-memory: it opens private temporary database on disk
+static bool isMemoryDb(const std::string& dbPath)
+{
+    if (dbPath == ":memory:")
+        return true;
+
+    if (dbPath.compare(0, 5, "file:"))
+        return false;
+
+    const std::string::size_type query = dbPath.find('?');
+    return !dbPath.compare(5, 8, ":memory:")
+            || (query != std::string::npos && dbPath.find("mode=memory", query) != std::string::npos);
+}
+
 class SQLiteDbImpl
 {
 public:
     sqlite3* conn = nullptr;
     std::string dbPath;
+    std::vector<sqlite3*> readers;
+    std::atomic<unsigned> nextReader;
+    SQLiteWriter* writer = nullptr;
+    SQLiteSnapshotter* snapshotter = nullptr;
+
+    SQLiteDbImpl():
+        nextReader(0)
+    {
+    }
+
+    sqlite3* getReader()
+    {
+        if (readers.empty())
+            return conn;
+
+        return readers[nextReader++ % readers.size()];
+    }
 };
 
+static void execPragma(sqlite3* conn, const std::string& pragma)
+{
+    char* error = nullptr;
+    int result = sqlite3_exec(conn, ("PRAGMA " + pragma).c_str(), nullptr, nullptr, &error);
+    if (result != SQLITE_OK) {
+        const std::string message = "Failed to set PRAGMA " + pragma + ": "
+                + (error ? error : sqlite3_errstr(result));
+        sqlite3_free(error);
+        NGREST_THROW_ASSERT(message);
+    }
+}
+
+static void setupConnection(sqlite3* conn, const SQLiteDbSettings& settings)
+{
+    if (settings.busyTimeout > 0)
+        sqlite3_busy_timeout(conn, settings.busyTimeout);
+    if (settings.mmapSize >= 0)
+        execPragma(conn, "mmap_size = " + toString(settings.mmapSize));
+    if (settings.cacheSize != 0)
+        execPragma(conn, "cache_size = " + toString(settings.cacheSize));
+}
+
+static void closeConnection(sqlite3* conn)
+{
+    // free all prepared ops
+    sqlite3_stmt* stmt;
+    while ((stmt = sqlite3_next_stmt(conn, 0)))
+        sqlite3_finalize(stmt);
+
+    // close db
+    int result = sqlite3_close(conn);
+    if (result != SQLITE_OK)
+        LogWarning() << "Failed to close database";
+}
+
+//! first keyword of the statement in upper case
+static std::string getStatementType(const std::string& query)
+{
+    std::string::size_type start = query.find_first_not_of(" \n\r\t(");
+    if (start == std::string::npos)
+        return std::string();
+    std::string::size_type end = query.find_first_of(" \n\r\t(;", start);
+    std::string dml = query.substr(start, (end != std::string::npos) ? (end - start) : end);
+
+    std::transform(dml.begin(), dml.end(), dml.begin(), ::toupper);
+
+    return dml;
+}
+
+static bool isTransactionControl(const std::string& type)
+{
+    return type == "BEGIN" || type == "COMMIT" || type == "END" || type == "ROLLBACK"
+            || type == "SAVEPOINT" || type == "RELEASE";
+}
+
 class SQLiteQueryImpl: public QueryImpl
 {
 private:
     SQLiteDb* db;
+    sqlite3* conn = nullptr;
     sqlite3_stmt* result = nullptr;
     unsigned fieldsCount = 0;
+    bool isWrite = false;
+    bool hasInsertId = false;
+    int64_t insertId = 0;
 
 public:
     SQLiteQueryImpl(SQLiteDb* db_):
@@ -70,17 +486,50 @@ public:
         NGREST_ASSERT(db->impl->conn, "Not Initialized");
         NGREST_ASSERT(!result, "Already prepared. Use reset() to finalize query.");
 
-        int res = sqlite3_prepare_v2(db->impl->conn, query.c_str(), query.size(), &result, nullptr);
+        // inside of the writer's transaction the reads must see it's uncommitted data,
+        // but the group transactions of the writer thread must not be visible to the others
+        const std::string& type = getStatementType(query);
+        const bool isSelect = type == "SELECT" || type == "WITH";
+        conn = (isSelect && (db->impl->writer || sqlite3_get_autocommit(db->impl->conn)))
+                ? db->impl->getReader() : db->impl->conn;
+
+        int res = sqlite3_prepare_v2(conn, query.c_str(), query.size(), &result, nullptr);
+        if (res == SQLITE_OK && conn != db->impl->conn && !sqlite3_stmt_readonly(result)) {
+            // CTE with data modification
+            sqlite3_finalize(result);
+            result = nullptr;
+            conn = db->impl->conn;
+            res = sqlite3_prepare_v2(conn, query.c_str(), query.size(), &result, nullptr);
+        }
+
         NGREST_ASSERT(res == SQLITE_OK, "error #" + toString(res) + ": "
-                      + std::string(sqlite3_errmsg(db->impl->conn))
+                      + std::string(sqlite3_errmsg(conn))
                       + "; db: \"" + db->impl->dbPath + "\""
                       + "\nWhile building query: \n----------\n" + query + "\n----------\n");
+
+        isWrite = db->impl->writer && conn == db->impl->conn && !sqlite3_stmt_readonly(result);
+
+        if (db->impl->writer && conn == db->impl->conn) {
+            // writer thread executes the statements in it's own transactions and discards the rows
+            std::string error;
+            if (isTransactionControl(type)) {
+                error = "Explicit transactions cannot be used with writer thread";
+            } else if (isWrite && sqlite3_column_count(result)) {
+                error = "Statements returning rows cannot be used with writer thread";
+            }
+
+            if (!error.empty()) {
+                reset();
+                NGREST_THROW_ASSERT(error + "; db: \"" + db->impl->dbPath + "\""
+                                    + "\nWhile building query: \n----------\n" + query + "\n----------\n");
+            }
+        }
     }
 
     inline void assertBindRes(int res)
     {
         NGREST_ASSERT(res == SQLITE_OK, "error #" + toString(res) + ": "
-                      + std::string(sqlite3_errmsg(db->impl->conn))
+                      + std::string(sqlite3_errmsg(conn))
                       + "; db: \"" + db->impl->dbPath + "\""
                       + "\nWhile binding query:\n"
                       + "\n----------\n"
@@ -118,17 +567,75 @@ public:
         assertBindRes(sqlite3_bind_text(result, arg + 1, value.c_str(), value.size(), SQLITE_TRANSIENT));
     }
 
+    void bindStringRef(int arg, const char* value, std::size_t size, bool /*terminated*/) override
+    {
+        assertBindRes(sqlite3_bind_text(result, arg + 1, value, static_cast<int>(size), SQLITE_STATIC));
+    }
+
+    void bindBlob(int arg, const char* data, std::size_t size) override
+    {
+        assertBindRes(sqlite3_bind_blob(result, arg + 1, data, static_cast<int>(size), SQLITE_TRANSIENT));
+    }
+
+    void bindBlobRef(int arg, const char* data, std::size_t size) override
+    {
+        assertBindRes(sqlite3_bind_blob(result, arg + 1, data, static_cast<int>(size), SQLITE_STATIC));
+    }
+
+    void bindBlobStream(int arg, const BlobReader& reader) override
+    {
+        // read the data directly into the buffer, which is passed to sqlite and freed by it
+        static const std::size_t chunkSize = 65536;
+        char* data = nullptr;
+        std::size_t size = 0;
+        std::size_t capacity = 0;
+        try {
+            for (;;) {
+                if (capacity - size < chunkSize) {
+                    capacity = (capacity + chunkSize) * 2;
+                    char* newData = static_cast<char*>(realloc(data, capacity));
+                    NGREST_ASSERT(newData, "Failed to allocate " + toString(capacity) + " bytes for blob");
+                    data = newData;
+                }
+                const std::size_t read = reader(data + size, capacity - size);
+                if (!read)
+                    break;
+                size += read;
+            }
+        } catch (...) {
+            free(data);
+            throw;
+        }
+
+        // sqlite frees the data even if the bind fails
+        assertBindRes(sqlite3_bind_blob(result, arg + 1, data, static_cast<int>(size), free));
+    }
+
     bool next() override
     {
         NGREST_ASSERT(result, "No statement prepared. Use prepare() before calling next().");
 
+        if (isWrite) {
+            WriteRequest request(result);
+            db->impl->writer->exec(request);
+            NGREST_ASSERT(request.status == SQLITE_OK,
+                          "error #" + toString(request.status) + ": " + request.error
+                          + "; db: \"" + db->impl->dbPath + "\""
+                          + "\nWhile executing query: \n----------\n"
+                          + std::string(sqlite3_sql(result))
+                          + "\n----------\n");
+            hasInsertId = true;
+            insertId = request.insertId;
+            return false;
+        }
+
         int status = sqlite3_step(result);
         if (status == SQLITE_ROW)
             return true;
 
         NGREST_ASSERT(status == SQLITE_DONE || status == SQLITE_OK,
                       "error #" + toString(status) + ": "
-                      + std::string(sqlite3_errmsg(db->impl->conn))
+                      + std::string(sqlite3_errmsg(conn))
                       + "; db: \"" + db->impl->dbPath + "\""
                       + "\nWhile executing query: \n----------\n"
                       + std::string(sqlite3_sql(result))
@@ -136,6 +643,13 @@ public:
         return false; // no data
     }
 
+    void rewind() override
+    {
+        // bindings are kept
+        if (result)
+            sqlite3_reset(result);
+    }
+
     bool resultIsNull(int column) override
     {
         return sqlite3_column_type(result, column) == SQLITE_NULL;
@@ -163,14 +677,51 @@ public:
 
     void resultString(int column, std::string& value) override
     {
+        std::size_t length = 0;
+        const char* res = resultStringRef(column, length);
+        value.assign(res, length);
+    }
+
+    const char* resultStringRef(int column, std::size_t& length) override
+    {
+        // sqlite3_column_bytes must be called after sqlite3_column_text to get the size of converted value
         const char* res = reinterpret_cast<const char*>(sqlite3_column_text(result, column));
-        value = res ? res : "";
+        if (!res) {
+            length = 0;
+            return "";
+        }
+
+        length = static_cast<std::size_t>(sqlite3_column_bytes(result, column));
+        return res;
     }
 
+    const char* resultBlobRef(int column, std::size_t& size) override
+    {
+        // points to the value in the row, no conversion is made for blob values
+        const char* res = reinterpret_cast<const char*>(sqlite3_column_blob(result, column));
+        size = static_cast<std::size_t>(sqlite3_column_bytes(result, column));
+        return res ? res : "";
+    }
+
+    int maxParamCount() override
+    {
+        NGREST_ASSERT(db->impl->conn, "Not Initialized");
+        // readers are opened by the same library, so the limit is the same
+        return sqlite3_limit(db->impl->conn, SQLITE_LIMIT_VARIABLE_NUMBER, -1);
+    }
+
+#ifdef SQLITE_STMTSTATUS_MEMUSED
+    std::size_t bufferSize() override
+    {
+        return result ? static_cast<std::size_t>(sqlite3_stmt_status(result, SQLITE_STMTSTATUS_MEMUSED, 0)) : 0;
+    }
+#endif
+
     int64_t lastInsertId() override
     {
         NGREST_ASSERT(db->impl->conn, "Not Initialized");
-        return sqlite3_last_insert_rowid(db->impl->conn);
+        // connection's last insert id is shared with other threads when writer thread is used
+        return hasInsertId ? insertId : sqlite3_last_insert_rowid(db->impl->conn);
     }
 
 };
@@ -184,28 +735,66 @@ SQLiteDb::SQLiteDb(const std::string& dbPath, const SQLiteDbSettings& settings):
     if (settings.enableSharedCache)
         sqlite3_enable_shared_cache(true);
 
-    if (!File(dbPath).isFile())
+    const bool isMemory = isMemoryDb(dbPath);
+    if (!isMemory && !dbPath.empty() && !File(dbPath).isFile())
         LogDebug() << "Database file does not exists: \"" << dbPath << "\"";
 
-    // open db
-    int result = sqlite3_open(dbPath.c_str(), &impl->conn);
-    NGREST_ASSERT(result == SQLITE_OK, "Failed to open database: " + dbPath);
-
-    if (settings.enableFK) {
-        sqlite3_stmt* stmt = nullptr;
+    try {
+        NGREST_ASSERT(settings.readerCount == 0 || (!isMemory && !dbPath.empty()),
+                      "Readers cannot be used with in-memory or temporary database");
+        // the writer connection is inside of the group transaction most of the time
+        NGREST_ASSERT(!settings.enableWriterThread || settings.readerCount > 0,
+                      "Writer thread requires readers to execute selects");
+        NGREST_ASSERT(settings.snapshotPath.empty() || isMemory,
+                      "Snapshots can only be used with in-memory database");
+
+        // open db
+        int result = sqlite3_open_v2(dbPath.c_str(), &impl->conn,
+                                     SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE | SQLITE_OPEN_URI, nullptr);
+        NGREST_ASSERT(result == SQLITE_OK, "Failed to open database: " + dbPath);
+
+        if (!settings.snapshotPath.empty())
+            SQLiteSnapshotter::restore(impl->conn, settings.snapshotPath);
+
+        setupConnection(impl->conn, settings);
+
+        if (settings.enableFK)
+            execPragma(impl->conn, "foreign_keys = ON");
+
+        if (!settings.journalMode.empty()) {
+            execPragma(impl->conn, "journal_mode = " + settings.journalMode);
+        } else if (settings.readerCount > 0) {
+            // readers do not block the writer and see it's committed data
+            execPragma(impl->conn, "journal_mode = WAL");
+        }
 
-        result = sqlite3_prepare_v2(impl->conn, "PRAGMA foreign_keys = ON;", -1, &stmt, nullptr);
-        NGREST_ASSERT(result == SQLITE_OK, sqlite3_errmsg(impl->conn));
+        if (!settings.synchronous.empty())
+            execPragma(impl->conn, "synchronous = " + settings.synchronous);
 
-        try {
-            NGREST_ASSERT(sqlite3_step(stmt) == SQLITE_DONE, "Failed to enable foreign keys: "
-                          + std::string(sqlite3_errmsg(impl->conn)));
-        } catch (...) {
-            sqlite3_finalize(stmt);
-            throw;
+        for (int i = 0; i < settings.readerCount; ++i) {
+            sqlite3* reader = nullptr;
+            result = sqlite3_open_v2(dbPath.c_str(), &reader,
+                                     SQLITE_OPEN_READONLY | SQLITE_OPEN_PRIVATECACHE | SQLITE_OPEN_URI, nullptr);
+            if (result != SQLITE_OK) {
+                sqlite3_close(reader);
+                NGREST_THROW_ASSERT("Failed to open database for reading: " + dbPath);
+            }
+            impl->readers.push_back(reader);
+            setupConnection(reader, settings);
         }
 
-        NGREST_ASSERT(sqlite3_finalize(stmt) == SQLITE_OK, sqlite3_errmsg(impl->conn));
+        if (settings.enableWriterThread)
+            impl->writer = new SQLiteWriter(impl->conn, settings.writerBatchSize);
+
+        if (!settings.snapshotPath.empty())
+            impl->snapshotter = new SQLiteSnapshotter(impl->conn, settings);
+    } catch (...) {
+        delete impl->writer;
+        for (sqlite3* reader : impl->readers)
+            sqlite3_close(reader);
+        sqlite3_close(impl->conn);
+        delete impl;
+        throw;
     }
 
     impl->dbPath = dbPath;
@@ -213,16 +802,26 @@ SQLiteDb::SQLiteDb(const std::string& dbPath, const SQLiteDbSettings& settings):
 
 SQLiteDb::~SQLiteDb()
 {
+    // commit all pending statements
+    delete impl->writer;
+    impl->writer = nullptr;
+
+    if (impl->snapshotter) {
+        try {
+            impl->snapshotter->snapshot(false);
+        } catch (const std::exception& err) {
+            LogWarning() << err.what();
+        }
+        delete impl->snapshotter;
+        impl->snapshotter = nullptr;
+    }
+
+    for (sqlite3* reader : impl->readers)
+        closeConnection(reader);
+    impl->readers.clear();
+
     if (impl->conn) {
-        // free all prepared ops
-        sqlite3_stmt* stmt;
-        while ((stmt = sqlite3_next_stmt(impl->conn, 0)))
-            sqlite3_finalize(stmt);
-
-        // close db
-        int result = sqlite3_close(impl->conn);
-        if (result != SQLITE_OK)
-            LogWarning() << "Failed to close database";
+        closeConnection(impl->conn);
         impl->conn = nullptr;
     }
 
@@ -234,6 +833,12 @@ QueryImpl* SQLiteDb::newQuery()
     return new SQLiteQueryImpl(this);
 }
 
+void SQLiteDb::snapshot()
+{
+    NGREST_ASSERT(impl->snapshotter, "Snapshots are not enabled");
+    impl->snapshotter->snapshot(true);
+}
+
 std::string SQLiteDb::getCreateTableQuery(const Entity& entity) const
 {
     std::string fieldsStr;
@@ -243,8 +848,7 @@ std::string SQLiteDb::getCreateTableQuery(const Entity& entity) const
         if (!fieldsStr.empty())
             fieldsStr += ",\n";
         fieldsStr += "  " + field.name + " ";
-        fieldsStr += getTypeName(field.type);
-        fieldsStr += " ";
+        fieldsStr += getColumnType(field) + " ";
         if (field.isPK)
             fieldsStr += "PRIMARY KEY ";
         if (field.isAutoincrement)
@@ -254,7 +858,7 @@ std::string SQLiteDb::getCreateTableQuery(const Entity& entity) const
         if (field.notNull)
             fieldsStr += "NOT NULL ";
         if (!field.defaultValue.empty()) {
-            if (field.type == Field::DataType::String) {
+            if (field.type == Field::DataType::String || field.type == Field::DataType::Char) {
                 fieldsStr += "DEFAULT \"" + field.defaultValue + "\"";
             } else {
                 fieldsStr += "DEFAULT " + field.defaultValue;
@@ -269,7 +873,10 @@ std::string SQLiteDb::getCreateTableQuery(const Entity& entity) const
         }
     }
 
-    return "CREATE TABLE IF NOT EXISTS " + entity.getTableName() + " (\n" + fieldsStr + fks + "\n)";
+    // requires PRIMARY KEY and can't be used with AUTOINCREMENT
+    const std::string& optionsStr = entity.getTableOptions().withoutRowid ? " WITHOUT ROWID" : "";
+
+    return "CREATE TABLE IF NOT EXISTS " + entity.getTableName() + " (\n" + fieldsStr + fks + "\n)" + optionsStr;
 }
 
 const std::string& SQLiteDb::getTypeName(Field::DataType type) const
@@ -282,6 +889,17 @@ const std::string& SQLiteDb::getTypeName(Field::DataType type) const
         "BIGINT",
         "DOUBLE",
         "INTEGER",
+        "TEXT",
+        "SMALLINT",
+        "TINYINT",
+        "REAL",
+        "CHAR(1)",
+        "DATE",
+        "TIMESTAMP",
+        "DECIMAL",
+        "BLOB",
+        "TEXT", // JSON1 functions work with text
+        "TEXT", // arrays are packed to JSON
         "TEXT"
     };
 
@@ -294,6 +912,39 @@ std::string SQLiteDb::getExistingTablesQuery() const
     return "SELECT name FROM sqlite_master WHERE type='table'";
 }
 
+std::string SQLiteDb::getCreateIndexQuery(const Entity& entity, const Index& index) const
+{
+    // gin and other access methods are PostgreSQL specific
+    if (!index.method.empty()) {
+        LogWarning() << "Index method " << index.method << " is not supported, skipping index " << index.name;
+        return std::string();
+    }
+
+    // no INCLUDE: add covering columns to the key unless it breaks uniqueness
+    Index result = index;
+    if (!result.isUnique)
+        result.fields.insert(result.fields.end(), result.include.begin(), result.include.end());
+    result.include.clear();
+
+    return Db::getCreateIndexQuery(entity, result);
+}
+
+std::string SQLiteDb::getExistingIndexesQuery() const
+{
+    return "SELECT name FROM sqlite_master WHERE type = 'index' AND tbl_name = ?";
+}
+
+std::string SQLiteDb::getEstimatedCountQuery(const std::string& /*table*/) const
+{
+    // sqlite_stat1 is created by ANALYZE
+    if (sqlite3_table_column_metadata(impl->conn, nullptr, "sqlite_stat1", "stat",
+                                      nullptr, nullptr, nullptr, nullptr, nullptr) != SQLITE_OK)
+        return std::string();
+
+    // stat starts with the number of rows
+    return "SELECT MAX(CAST(stat AS INTEGER)) FROM sqlite_stat1 WHERE tbl = ?";
+}
+
 
 
 } // namespace ngrest
@@ -29,6 +29,40 @@ struct SQLiteDbSettings
 {
     bool enableSharedCache = true;
     bool enableFK = true;
+
+    //! number of read-only connections to execute SELECTs on, 0 - use single connection for all queries
+    //! other queries are executed on the writer connection.
+    //! readers use private cache and WAL journal mode is enabled if journalMode is not set
+    int readerCount = 0;
+    //! PRAGMA journal_mode: "WAL", "DELETE", ... empty - keep default
+    std::string journalMode;
+    //! PRAGMA synchronous: "OFF", "NORMAL", "FULL", ... empty - keep default
+    std::string synchronous;
+    //! PRAGMA mmap_size in bytes, -1 - keep default
+    int64_t mmapSize = -1;
+    //! PRAGMA cache_size: pages if positive, KiB if negative, 0 - keep default
+    int cacheSize = 0;
+    //! time in ms to wait for locked database, 0 - fail immediately
+    int busyTimeout = 0;
+
+    //! execute data modifying statements in the writer thread.
+    //! statements from all threads are committed in groups: one transaction per batch,
+    //! failed statement is rolled back without affecting the others in the batch.
+    //! calling thread is blocked until the batch containing it's statement is committed.
+    //! explicit transactions and statements returning rows (INSERT ... RETURNING) are rejected in this mode.
+    //! requires readers: the selects must not see the data of not yet committed batch
+    bool enableWriterThread = false;
+    //! max number of statements committed in one transaction by the writer thread
+    int writerBatchSize = 1000;
+
+    //! file to store the snapshots of in-memory database to, empty - snapshots are disabled.
+    //! use with ":memory:" or shared cache URI like "file:sessions?mode=memory&cache=shared".
+    //! the database is restored from the file on startup and the last snapshot is taken on close
+    std::string snapshotPath;
+    //! interval in ms between snapshots taken in background thread, 0 - take snapshot on close only
+    int snapshotInterval = 60000;
+    //! number of pages copied at once, the database is not locked between the steps
+    int snapshotPagesPerStep = 256;
 };
 
 class SQLiteDbImpl;
@@ -37,14 +71,21 @@ class SQLiteQueryImpl;
 class SQLiteDb: public Db
 {
 public:
+    //! dbPath starting with "file:" is parsed as URI: "file:data.db?mode=ro", "file::memory:?cache=shared"
     SQLiteDb(const std::string& dbPath, const SQLiteDbSettings& settings = SQLiteDbSettings());
     ~SQLiteDb();
 
     QueryImpl* newQuery() override;
 
+    //! write the snapshot of in-memory database to settings.snapshotPath now
+    void snapshot();
+
     std::string getCreateTableQuery(const Entity& entity) const override;
     const std::string& getTypeName(Field::DataType type) const override;
     std::string getExistingTablesQuery() const override;
+    std::string getEstimatedCountQuery(const std::string& table) const override;
+    std::string getCreateIndexQuery(const Entity& entity, const Index& index) const override;
+    std::string getExistingIndexesQuery() const override;
 
 private:
     SQLiteDb(const SQLiteDb&);
@@ -18,10 +18,10 @@ struct User
     std::string name;
 
     // *unique: true
-    // *type: varchar(64)
+    // *length: 64
     std::string email;
 
-    // *type: timestamp
+    // *dataType: Timestamp
     // *default: CURRENT_TIMESTAMP
     // *ignoreOnInsert: true
     std::string registered;
@@ -1,4 +1,6 @@
 #include <list>
+#include <set>
+#include <vector>
 #include <iostream>
 
 #include <ngrest/utils/Log.h>
@@ -75,10 +77,18 @@ void example1(Db& db)
     NGREST_ASSERT(resList2.size() == 3, "Test failed");
 
     // select query and IN statement
-//    const std::list<User>& resList3 = users.select("id IN ?", std::list<int>{1, 2, 3});
+    const std::list<User>& resList3 = users.select("id IN ?", std::list<int>{id, id + 1, id + 2});
+    NGREST_ASSERT(resList3.size() == 3, "Test failed");
+
     // select query and IN statement
-//    const std::list<User>& resList4 = users.select("id IN ? AND name LIKE ?",
-//            std::list<int>{1, 2, 3}, "%Ja%");
+    const std::list<User>& resList4 = users.select("id IN ? AND name LIKE ?",
+            std::vector<int>{id, id + 1, id + 2}, "Ja%");
+    NGREST_ASSERT(resList4.size() == 2, "Test failed");
+
+    // select query and NOT IN statement
+    const std::list<User>& resList4a = users.select("id NOT IN ?", std::set<int>{id});
+    NGREST_ASSERT(resList4a.size() == 3, "Test failed");
+
     // select all items, desired fields
     const std::list<User>& resList5 = users.selectFields({"id", "name"}, "");
     NGREST_ASSERT(resList5.size() == 4, "Test failed");
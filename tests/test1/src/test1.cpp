@@ -1,5 +1,16 @@
+#include <ctype.h>
+#include <stdio.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
 #include <list>
 #include <iostream>
+#include <iterator>
+#include <limits>
+#include <stdexcept>
+#include <thread>
+#include <vector>
 
 #include <ngrest/utils/Log.h>
 #include <ngrest/utils/console.h>
@@ -14,7 +25,10 @@
 #ifdef HAS_POSTGRES
 #include <ngrest/db/PostgresDb.h>
 #endif
+#include <ngrest/db/QueryImpl.h>
 #include <ngrest/db/Table.h>
+#include <ngrest/db/PreparedStatement.h>
+#include <ngrest/db/BatchLoader.h>
 
 #include "test1.h"
 
@@ -59,6 +73,49 @@ void printCmp(const Test1& a, const Test1& b)
     std::cout << ((a.ne == b.ne)         ? colorDefault : colorTextMagenta) << "ne     " << a.ne       << " / " << b.ne     << colorDefault << std::endl;
 }
 
+//! driver implementing the required methods only
+class MinimalQueryImpl: public QueryImpl
+{
+public:
+    void reset() override {}
+    void prepare(const std::string&) override {}
+    void bindNull(int) override {}
+    void bindBool(int, bool) override {}
+    void bindInt(int, int) override {}
+    void bindBigInt(int, int64_t) override {}
+    void bindFloat(int, double) override {}
+    void bindString(int, const std::string&) override {}
+    bool next() override { return false; }
+    bool resultIsNull(int) override { return false; }
+    bool resultBool(int) override { return false; }
+    int resultInt(int) override { return 0; }
+    int64_t resultBigInt(int) override { return 0; }
+    double resultFloat(int) override { return 0; }
+    void resultString(int column, std::string& value) override { value = "column " + std::to_string(column); }
+    int64_t lastInsertId() override { return 0; }
+};
+
+#ifdef __cpp_impl_coroutine
+QueryTask selectCoro(QueryScheduler& scheduler, Table<Test1>& table, std::list<int> ids,
+                     Test1& one, std::list<Test1>& list)
+{
+    one = co_await table.selectOneAsync(scheduler, "id = ?", ids.front());
+    list = co_await table.selectAsync(scheduler, "id IN ?", ids);
+    co_await table.selectOneAsync(scheduler, "id = ?", -1);
+}
+
+QueryTask throwCoro(QueryScheduler& scheduler, Db& db, bool& caught)
+{
+    Query& query = scheduler.query(db);
+    query.prepare("SELECT 1");
+    try {
+        co_await QueryAwaitable<int>(scheduler, query, [](Query&) -> int { throw 1; });
+    } catch (int) {
+        caught = true;
+    }
+}
+#endif
+
 void test1(Db& db, const std::string& driverName)
 {
     std::cout << "------------ testing " + driverName + " driver -----------------\n";
@@ -143,6 +200,288 @@ void test1(Db& db, const std::string& driverName)
         printCmp(test3, test33Res);
 
 
+    tableTest1.insert(std::list<Test1> {test1, test2, test3});
+    expect(tableTest1.select().size() == 6, "list of items inserted");
+    expect(tableTest1.select("id IN ?", std::list<int>{id1, id2, id3}).size() == 3, "IN list selected");
+    expect(tableTest1.select("id NOT IN ? AND id > ?", std::list<int>{id1, id2, id3}, 0).size() == 3,
+           "NOT IN list selected");
+    expect(tableTest1.select("id IN ?", std::list<int>()).empty(), "empty IN list");
+    expect(tableTest1.count("id NOT IN ?", std::vector<int>()) == tableTest1.count(), "empty NOT IN list");
+    expect(tableTest1.count("str <> '?' AND id IN ?", std::list<int>{id1, id2, id3}) == 3,
+           "question mark in literal is not a parameter");
+    std::vector<int> hugeList(70000);
+    for (std::size_t index = 0; index < hugeList.size(); ++index)
+        hugeList[index] = -1 - static_cast<int>(index);
+    std::string hugeListError;
+    int hugeListCount = -1;
+    try {
+        hugeListCount = tableTest1.count("id IN ?", hugeList);
+    } catch (const std::exception& error) {
+        hugeListError = error.what();
+    }
+    // PostgreSQL binds the list as one array parameter
+    expect(hugeListCount == 0 || hugeListError.find("exceeds the limit") != std::string::npos,
+           "too long IN list is rejected before executing");
+
+
+    PreparedStatement<int> selectStr = db.prepare<int>("SELECT str FROM test1 WHERE id = ?");
+    std::string str;
+    expect(selectStr.execute(id2), "prepared statement executed");
+    selectStr.result(0, str);
+    expect(str == test2.str, "prepared statement result");
+    expect(selectStr.execute(id3), "prepared statement executed again");
+    selectStr.result(0, str);
+    expect(str == test3.str, "prepared statement result with new argument");
+
+    // the string is bound without copying, the reference to the value is valid until next()
+    Query refQuery(db);
+    refQuery.prepare("SELECT str, nstr FROM test1 WHERE str = ? ORDER BY id");
+    const std::string borrowedStr = test2.str;
+    refQuery.bindBorrowed(0, borrowedStr);
+    std::size_t refLength = 0;
+    const char* strRef = refQuery.next() ? refQuery.resultStringRef(0, refLength) : "";
+    std::string nstr;
+    refQuery.resultString(1, nstr);
+    expect(std::string(strRef, refLength) == test2.str && nstr == *test2.nstr,
+           "borrowed parameter and string reference");
+
+    // parameter buffers are reused, but not kept after large value is bound
+    Query bufferQuery(db);
+    std::size_t bufferSizes[2] = {0, 0};
+    for (std::size_t& size : bufferSizes) {
+        bufferQuery.prepare("SELECT COUNT(*) FROM test1 WHERE str = ?", test2.str);
+        bufferQuery.next();
+        bufferQuery.reset();
+        size = bufferQuery.bufferSize();
+    }
+    bufferQuery.prepare("SELECT COUNT(*) FROM test1 WHERE str = ?", std::string(4 * 1024 * 1024, 'x'));
+    bufferQuery.next();
+    bufferQuery.reset();
+    expect(bufferSizes[1] == bufferSizes[0] && bufferQuery.bufferSize() < 1024 * 1024,
+           "buffers reused and shrunk after large value");
+
+    MinimalQueryImpl minimalQuery;
+    const char* ref0 = minimalQuery.resultStringRef(0, refLength);
+    const char* ref1 = minimalQuery.resultStringRef(1, refLength);
+    expect(std::string(ref0) == "column 0" && std::string(ref1, refLength) == "column 1",
+           "default string reference");
+#if __cplusplus >= 201703L
+    Query viewQuery(db);
+    viewQuery.prepare("SELECT str FROM test1 WHERE str = ?");
+    viewQuery.bind(0, std::string_view(test2.str));
+    std::string_view view;
+    if (viewQuery.next())
+        viewQuery.result(0, view);
+    expect(view == test2.str && viewQuery.resultStringView(0) == test2.str, "string view bound and read");
+#endif
+
+
+    BatchLoader<Test1, int> loader(tableTest1, &Test1::id, "id");
+    int loaded = 0;
+    int notFound = 0;
+    for (int id : {id1, id2, id1, -1})
+        loader.load(id, [&](const Test1* item) { item ? ++loaded : ++notFound; });
+    loader.dispatch();
+    expect(loaded == 3 && notFound == 1, "batch loaded");
+
+    SingleFlight singleFlight;
+    tableTest1.setSingleFlight(&singleFlight);
+    expect(tableTest1.selectOne("id = ?", id2).id == id2, "select with single flight");
+    tableTest1.setSingleFlight(nullptr);
+    expect(SingleFlight::makeKey(&db, "SELECT 1", 1) != SingleFlight::makeKey(&singleFlight, "SELECT 1", 1),
+           "single flight key depends on database");
+
+    // identical concurrent calls are executed once, every caller gets the result or the exception
+    for (bool fail : {false, true}) {
+        const int threadCount = 8;
+        std::atomic<int> executed(0);
+        std::atomic<int> ready(0);
+        std::atomic<bool> go(false);
+        std::vector<std::string> results(threadCount);
+        std::vector<std::thread> threads;
+        const std::string key = SingleFlight::makeKey(&db, "SELECT str FROM test1 WHERE id = ?", id2);
+        for (int index = 0; index < threadCount; ++index) {
+            threads.push_back(std::thread([&, index] {
+                ++ready;
+                while (!go)
+                    std::this_thread::yield();
+                try {
+                    results[index] = singleFlight.execute<std::string>(key, [&] {
+                        ++executed;
+                        // slow source: the other callers join while it's executed
+                        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+                        if (fail)
+                            throw std::runtime_error("source failed");
+                        return test2.str;
+                    });
+                } catch (const std::exception& error) {
+                    results[index] = error.what();
+                }
+            }));
+        }
+        while (ready < threadCount)
+            std::this_thread::yield();
+        go = true;
+        for (std::thread& thread : threads)
+            thread.join();
+
+        const std::string& expected = fail ? "source failed" : test2.str;
+        expect(executed == 1 && std::count(results.begin(), results.end(), expected) == threadCount,
+               fail ? "single flight error delivered to every caller" : "single flight coalesces concurrent calls");
+    }
+
+    QueryScheduler scheduler;
+    std::list<Test1> asyncList;
+    Test1 asyncOne;
+    tableTest1.selectAsync(scheduler, [&](const std::list<Test1>& res) { asyncList = res; },
+                           "id IN ?", std::list<int>{id1, id2, id3});
+    tableTest1.selectOneAsync(scheduler, [&](const Test1& res) { asyncOne = res; }, "id = ?", id2);
+    scheduler.run();
+    expect(asyncList.size() == 3 && asyncOne == test2, "async select");
+#ifdef __cpp_impl_coroutine
+    asyncList.clear();
+    QueryTask task = selectCoro(scheduler, tableTest1, {id2, id3}, asyncOne, asyncList);
+    expect(!task.isDone(), "coroutine is suspended until the result is ready");
+    scheduler.run();
+    bool taskFailed = false;
+    try {
+        task.get();
+    } catch (const std::exception&) {
+        taskFailed = true;
+    }
+    expect(task.isDone() && taskFailed && asyncOne == test2 && asyncList.size() == 2, "async select coroutine");
+    bool caught = false;
+    QueryTask throwTask = throwCoro(scheduler, db, caught);
+    scheduler.run();
+    expect(throwTask.isDone() && caught, "coroutine resumed with non standard exception");
+#endif
+
+
+    ngrest::Table<Test2> tableTest2(db);
+    tableTest2.create();
+    tableTest2.deleteAll();
+    tableTest2 << Test2 {0, id2} << Test2 {0, id3} << Test2 {0, Nullable<int>()};
+    const std::list<std::tuple<Test2, Test1>>& joined = tableTest2.selectJoined<Test1>("t1.id = ?", id3);
+    expect(joined.size() == 1 && std::get<1>(joined.front()) == test3, "select joined");
+    expect(tableTest2.selectJoined<Test1>().size() == 3, "select left joined");
+
+    const std::list<Test1>& parents = tableTest1.select("id IN ?", std::list<int>{id1, id2, id3});
+    const std::unordered_map<int, std::list<Test2>>& children = tableTest2.loadFor(parents, &Test2::nid);
+    expect(children.size() == 3 && children.at(id1).empty() && children.at(id2).size() == 1
+           && *children.at(id3).front().nid == id3, "children loaded for parents");
+
+    expect(tableTest1.count("id IN ?", std::list<int>{id1, id2, id3}) == 3, "count");
+    expect(tableTest1.exists("id = ?", id1) && !tableTest1.exists("id = ?", -1), "exists");
+    expect(tableTest1.estimatedCount() >= 3, "estimated count");
+
+    int indexesFound = 0;
+    std::string name;
+    Query indexes(db);
+    indexes.prepare(db.getExistingIndexesQuery(), "test1");
+    while (indexes.next()) {
+        indexes.resultString(0, name);
+        indexesFound += (name == "test1_str_idx" || name == "test1_b_e") ? 1 : 0;
+    }
+    expect(indexesFound == 2, "indexes created");
+    expect(tableTest1.max<int>("id", "id IN ?", std::list<int>{id1, id2, id3}) == id3, "max");
+    expect(tableTest1.sum<Nullable<double>>("d", "id = ?", -1).isNull(), "sum of no rows is null");
+
+    ngrest::Table<Test3> tableTest3(db);
+    tableTest3.create();
+    tableTest3.deleteAll();
+    tableTest3.setInsertFieldsInclusion({"id"}, ngrest::FieldsInclusion::Exclude);
+    const std::vector<char> blob = {'\0', '\x01', '\xff', 'a', '\\', '\''};
+    const std::list<TestItem> items = {{"quote \" and \\", -1, 0.1, {"a", "b"}}, {"", 0, Nullable<double>(), {}}};
+    tableTest3 << Test3 {0, 30000, -100, 1.5f, "UA", "2024-02-29", "2024-02-29 12:34:56", "12.50", blob, items,
+                         {1, 2, 3}, {"a b", "quote \" and \\", "", "NULL", "{}"}};
+    const Test3& compact = tableTest3.selectOne("code = ?", "UA");
+    expect(compact.s == 30000 && compact.t == -100 && compact.r == 1.5f, "compact numeric types");
+    expect(compact.date == "2024-02-29" && compact.timestamp == "2024-02-29 12:34:56", "date and timestamp");
+    expect(std::stod(compact.price) == 12.5, "decimal");
+    expect(compact.blob.empty(), "lazy field is not selected");
+    expect(compact.items == items, "json field");
+    expect(compact.groups == std::vector<int>{1, 2, 3}
+           && compact.labels == std::vector<std::string>{"a b", "quote \" and \\", "", "NULL", "{}"}, "array fields");
+    Test3 lazy = compact;
+    tableTest3.fetchLazy(lazy, &Test3::blob);
+    expect(lazy.blob == blob, "blob");
+    tableTest3 << Test3 {0, 1, 2, 3.0f, "PL", "2024-03-01", "2024-03-01 00:00:00", "1", {'b'}, {}, {}, {}};
+    std::list<Test3> lazyList = tableTest3.select("id > ?", 0);
+    tableTest3.fetchLazy(lazyList, &Test3::blob);
+    expect(lazyList.size() == 2 && lazyList.front().blob == blob && lazyList.back().blob == std::vector<char>{'b'},
+           "lazy field batch fetched");
+
+    const std::string& overlaps = (driverName == "PostgreSQL") ? "groups && ?"
+            : (driverName == "MySQL") ? "JSON_OVERLAPS(groups, ?)"
+            : "EXISTS (SELECT 1 FROM json_each(groups) AS g, json_each(?) AS v WHERE g.value = v.value)";
+    expect(tableTest3.select(overlaps, std::vector<int>{2, 100}).size() == 1, "array value parameter");
+    expect(ngrest::Index::parse("test3_groups_gin(groups) using gin").method == "gin", "index method");
+
+    const std::string json = " {\"extra\": {\"a\": [1, null, \"}\"]}, \"name\": \"\\u00e9\\ud83d\\ude00\","
+        " \"count\": 3, \"weight\": null, \"tags\": [\"t\"]} ";
+    TestItem parsed {"", 0, 1.0, {}};
+    ngrest::fromJsonColumn(json.c_str(), json.size(), parsed);
+    expect(parsed.name == "\xc3\xa9\xf0\x9f\x98\x80" && parsed.count == 3 && parsed.weight.isNull()
+           && parsed.tags == std::list<std::string>{"t"}, "json parsing");
+    expect(ngrest::toJsonColumn(std::vector<double>{std::numeric_limits<double>::infinity(), 0.5}) == "[null,0.5]",
+           "json non-finite number");
+
+    // 1MB sent by 4KB chunks
+    std::size_t streamed = 0;
+    Query streamBlob(db);
+    streamBlob.prepare("UPDATE test3 SET blob = ? WHERE id = ?");
+    streamBlob.bindBlobStream(0, [&streamed](char* buffer, std::size_t size) {
+        const std::size_t read = std::min<std::size_t>(std::min<std::size_t>(size, 4096), 1048576 - streamed);
+        for (std::size_t pos = 0; pos < read; ++pos)
+            buffer[pos] = static_cast<char>((streamed + pos) % 251);
+        streamed += read;
+        return read;
+    });
+    streamBlob.bind(1, compact.id);
+    streamBlob.next();
+    Query readBlob(db);
+    readBlob.prepare("SELECT blob FROM test3 WHERE id = ?", compact.id);
+    std::size_t blobSize = 0;
+    const char* blobData = readBlob.next() ? readBlob.resultBlobRef(0, blobSize) : nullptr;
+    expect(blobSize == 1048576 && blobData[1000] == static_cast<char>(1000 % 251), "blob stream");
+
+    // more than two PostgreSQL pipeline segments of 512 statements
+    const int batchSize = 1100;
+    std::list<Test1> batch;
+    for (int index = 0; index < batchSize; ++index)
+        batch.push_back(Test1 {0, "batch", false, 0, Val1, "batch " + std::to_string(index), index % 2 == 0,
+                               static_cast<double>(index), Val3});
+    tableTest1.insert(batch);
+    const std::list<Test1>& batchRes = tableTest1.select("defStr = ? ORDER BY d", "batch");
+    bool batchEq = static_cast<int>(batchRes.size()) == batchSize;
+    int batchIndex = 0;
+    for (const Test1& item : batchRes) {
+        batchEq &= item.str == "batch " + std::to_string(batchIndex) && item.b == (batchIndex % 2 == 0)
+                && item.d == batchIndex && item.e == Val3;
+        ++batchIndex;
+    }
+    expect(batchEq, "batch inserted and selected");
+
+    // the error of the row in the middle of the batch must be reported
+    std::list<Test1> dupBatch = batch;
+    int dupId = 100000;
+    for (Test1& item : dupBatch) {
+        item.id = ++dupId;
+        item.defStr = "dup";
+    }
+    std::next(dupBatch.begin(), batchSize * 2 / 3)->id = id1;
+    std::string dupError;
+    try {
+        tableTest1.insert(dupBatch, {}, FieldsInclusion::Exclude);
+    } catch (const std::exception& error) {
+        dupError = error.what();
+    }
+    std::transform(dupError.begin(), dupError.end(), dupError.begin(), ::tolower);
+    expect(dupError.find("unique") != std::string::npos || dupError.find("duplicate") != std::string::npos,
+           "batched insert reports duplicate key");
+    tableTest1.deleteWhere("defStr = ?", "dup");
+
+
     if (failed == 0) {
         std::cout << "  all " << passed << " tests passed\n";
         std::cout << "---------- " + driverName + " driver test PASSED ---------------\n\n";
@@ -152,6 +491,261 @@ void test1(Db& db, const std::string& driverName)
     }
 }
 
+#ifdef HAS_POSTGRES
+void testPostgres(PostgresDb& db)
+{
+    std::cout << "------------ testing PostgreSQL specific features -----------------\n";
+
+    // more than one segment of 512 statements
+    const int count = 1100;
+    PostgresPipeline pipeline(db);
+    std::vector<Query*> queries;
+    for (int index = 0; index < count; ++index) {
+        Query& query = pipeline.add("SELECT ?::integer * 2");
+        query.bind(0, index);
+        queries.push_back(&query);
+    }
+    pipeline.flush();
+
+    int matched = 0;
+    for (int index = 0; index < count; ++index)
+        matched += (queries[index]->next() && queries[index]->resultInt(0) == index * 2) ? 1 : 0;
+
+    if (matched == count) {
+        std::cout << "Testing pipeline" << colorBright << colorTextGreen << logResultSuccess << colorDefault << std::endl;
+        std::cout << "---------- PostgreSQL specific test PASSED ---------------\n\n";
+    } else {
+        std::cerr << colorBright << colorTextRed << "  pipeline returned " << matched << " of " << count << " results\n";
+        std::cerr << "---------- PostgreSQL specific test FAILED ---------------\n\n" << colorDefault;
+    }
+}
+#endif
+
+#ifdef HAS_SQLITE
+void removeDbFiles(const std::string& path)
+{
+    remove(path.c_str());
+    remove((path + "-wal").c_str());
+    remove((path + "-shm").c_str());
+}
+
+void testSQLite()
+{
+    std::cout << "------------ testing SQLite specific features -----------------\n";
+    int passed = 0;
+    int failed = 0;
+    auto expect = [&](bool ex, const char* text) {
+        std::cout << "Testing " << text;
+        if (ex) {
+            std::cout << colorBright << colorTextGreen << logResultSuccess << colorDefault << std::endl;
+            ++passed;
+        } else {
+            std::cout << colorBright << colorTextRed << logResultFailed << colorDefault << std::endl;
+            ++failed;
+        }
+    };
+
+    {
+        removeDbFiles("test_readers.db");
+        SQLiteDbSettings settings;
+        settings.readerCount = 2;
+        SQLiteDb db("test_readers.db", settings);
+
+        Query write(db);
+        write.query("CREATE TABLE kv (k INTEGER PRIMARY KEY, v TEXT)");
+        write.reset();
+        write.query("INSERT INTO kv VALUES (1, 'a')");
+
+        // another connection's transaction is in progress, readers see committed data only
+        {
+            SQLiteDb other("test_readers.db");
+            Query otherWrite(other);
+            otherWrite.query("BEGIN");
+            otherWrite.reset();
+            otherWrite.query("INSERT INTO kv VALUES (2, 'b')");
+
+            Query read(db);
+            read.prepare("SELECT COUNT(*) FROM kv");
+            expect(read.next() && read.resultInt(0) == 1, "read from reader during write");
+
+            otherWrite.reset();
+            otherWrite.query("COMMIT");
+        }
+
+        Query read(db);
+        read.prepare("SELECT COUNT(*) FROM kv");
+        expect(read.next() && read.resultInt(0) == 2, "reader sees committed data");
+
+        // own transaction is in progress, the reads are executed on the writer
+        write.reset();
+        write.query("BEGIN");
+        write.reset();
+        write.query("INSERT INTO kv VALUES (4, 'd')");
+        read.reset();
+        read.prepare("SELECT COUNT(*) FROM kv");
+        expect(read.next() && read.resultInt(0) == 3, "read inside of transaction sees own writes");
+        read.reset();
+        write.reset();
+        write.query("ROLLBACK");
+
+        // starts like a select, but modifies the data: executed on the writer
+        Query cte(db);
+        cte.query("WITH n(k) AS (SELECT 3) INSERT INTO kv SELECT k, 'c' FROM n");
+        read.reset();
+        read.prepare("SELECT v FROM kv WHERE k = 3");
+        std::string value;
+        if (read.next())
+            read.resultString(0, value);
+        expect(value == "c", "CTE with INSERT executed on writer");
+    }
+
+    {
+        // readers open the same file as the writer
+        SQLiteDbSettings settings;
+        settings.readerCount = 1;
+        SQLiteDb db("file:test_readers.db", settings);
+        Query read(db);
+        read.prepare("SELECT COUNT(*) FROM kv");
+        expect(read.next() && read.resultInt(0) == 3, "readers opened by URI");
+    }
+    removeDbFiles("test_readers.db");
+
+    {
+        removeDbFiles("test_writer.db");
+        SQLiteDbSettings settings;
+        settings.enableWriterThread = true;
+
+        bool noReadersFailed = false;
+        try {
+            SQLiteDb db("test_writer.db", settings);
+        } catch (const std::exception&) {
+            noReadersFailed = true;
+        }
+        expect(noReadersFailed, "writer thread requires readers");
+
+        settings.readerCount = 1;
+        SQLiteDb db("test_writer.db", settings);
+
+        Query query(db);
+        query.query("CREATE TABLE kv (k INTEGER PRIMARY KEY, v TEXT)");
+        query.reset();
+        query.query("INSERT INTO kv VALUES (1, 'a')");
+
+        // the writes queued while the slow one is executed are committed in one group,
+        // duplicate key fails its own statement only
+        std::atomic<int> prepared(0);
+        std::atomic<bool> go(false);
+        std::atomic<int> errors(0);
+        std::vector<std::thread> writers;
+        for (int key = 0; key < 5; ++key) {
+            writers.push_back(std::thread([&db, &prepared, &go, &errors, key] {
+                try {
+                    Query query(db);
+                    query.prepare("INSERT INTO kv VALUES (?, 'b')", key ? (key + 10) : 1);
+                    ++prepared;
+                    while (!go)
+                        std::this_thread::yield();
+                    query.next();
+                } catch (const std::exception&) {
+                    ++errors;
+                }
+            }));
+        }
+        while (prepared < 5)
+            std::this_thread::yield();
+
+        std::thread slow([&db] {
+            Query query(db);
+            query.query("CREATE TABLE filler AS WITH RECURSIVE n(i) AS (SELECT 1 UNION ALL SELECT i + 1 FROM n"
+                        " WHERE i < 1000000) SELECT i FROM n");
+        });
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        go = true;
+
+        for (std::thread& writer : writers)
+            writer.join();
+        slow.join();
+
+        query.reset();
+        query.prepare("SELECT COUNT(*) FROM kv WHERE k > 10");
+        expect(errors == 1 && query.next() && query.resultInt(0) == 4, "failed write does not affect its group");
+
+        // the writer thread commits in it's own transactions and does not return rows
+        auto prepareError = [&db](const std::string& queryStr) {
+            try {
+                Query query(db);
+                query.prepare(queryStr);
+            } catch (const std::exception& error) {
+                return std::string(error.what());
+            }
+            return std::string();
+        };
+        expect(prepareError("BEGIN").find("transactions") != std::string::npos,
+               "explicit transaction rejected with writer thread");
+        expect(prepareError("INSERT INTO kv VALUES (30, 'c') RETURNING k").find("returning rows") != std::string::npos,
+               "INSERT RETURNING rejected with writer thread");
+    }
+    removeDbFiles("test_writer.db");
+
+    {
+        removeDbFiles("test_snapshot.db");
+        removeDbFiles("test_snapshot_copy.db");
+        SQLiteDbSettings settings;
+        settings.snapshotPath = "test_snapshot.db";
+        settings.snapshotInterval = 0;
+
+        {
+            SQLiteDb db(":memory:", settings);
+            Query query(db);
+            query.query("CREATE TABLE kv (k INTEGER PRIMARY KEY, v TEXT)");
+            query.reset();
+            query.query("INSERT INTO kv VALUES (1, 'a')");
+            db.snapshot();
+
+            // keep the snapshot, the last one is taken on close
+            std::ifstream src("test_snapshot.db", std::ios::binary);
+            std::ofstream dst("test_snapshot_copy.db", std::ios::binary);
+            dst << src.rdbuf();
+
+            query.reset();
+            query.query("UPDATE kv SET v = 'b'");
+        }
+
+        std::string value;
+        {
+            settings.snapshotPath = "test_snapshot_copy.db";
+            SQLiteDb db(":memory:", settings);
+            Query query(db);
+            query.prepare("SELECT v FROM kv WHERE k = 1");
+            if (query.next())
+                query.resultString(0, value);
+        }
+        expect(value == "a", "snapshot restored");
+
+        value.clear();
+        {
+            settings.snapshotPath = "test_snapshot.db";
+            SQLiteDb db(":memory:", settings);
+            Query query(db);
+            query.prepare("SELECT v FROM kv WHERE k = 1");
+            if (query.next())
+                query.resultString(0, value);
+        }
+        expect(value == "b", "snapshot taken on close");
+    }
+    removeDbFiles("test_snapshot.db");
+    removeDbFiles("test_snapshot_copy.db");
+
+    if (failed == 0) {
+        std::cout << "  all " << passed << " tests passed\n";
+        std::cout << "---------- SQLite specific test PASSED ---------------\n\n";
+    } else {
+        std::cerr << colorBright << colorTextRed << "  failed " << failed << " tests of " << (passed + failed) << "\n";
+        std::cerr << "---------- SQLite specific test FAILED ---------------\n\n" << colorDefault;
+    }
+}
+#endif
+
 }
 }
 
@@ -161,6 +755,7 @@ int main()
 #ifdef HAS_SQLITE
         ngrest::SQLiteDb sqliteDb("test.db");
         ngrest::test::test1(sqliteDb, "SQLite");
+        ngrest::test::testSQLite();
 #endif
 
 #ifdef HAS_MYSQL
@@ -181,6 +776,7 @@ int main()
 
         ngrest::PostgresDb postgresDb({"test_ngrestdb", "ngrestdb", "ngrestdb"});
         ngrest::test::test1(postgresDb, "PostgreSQL");
+        ngrest::test::testPostgres(postgresDb);
 #endif
     } catch (const std::exception& exception) {
         ::ngrest::LogError() << "Test failed: \n" << exception.what();
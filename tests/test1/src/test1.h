@@ -2,6 +2,8 @@
 #define NGREST_DB_TEST_ENTITIES_H
 
 #include <string>
+#include <list>
+#include <vector>
 #include <iostream>
 #include <ngrest/common/Nullable.h>
 
@@ -16,6 +18,7 @@ enum TestEnum
 };
 
 // *table: test1
+// *index: test1_b_e(b, e) INCLUDE(d) WHERE nb IS NOT NULL
 struct Test1
 {
     // *pk: true
@@ -33,6 +36,7 @@ struct Test1
     TestEnum defE;
 
 
+    // *index: true
     std::string str;
     bool b;
     double d;
@@ -63,15 +67,75 @@ struct Test1
 };
 
 // *table: test2
+// *fillfactor: 90
 struct Test2
 {
     // *pk: true
     // *autoincrement: true
     int id;
 
+    // *fk: test1 id
+    // *onDelete: cascade
     Nullable<int> nid;
 };
 
+// stored within JSON field of test3
+// *json: true
+struct TestItem
+{
+    std::string name;
+    int count;
+    Nullable<double> weight;
+    std::list<std::string> tags;
+
+    bool operator==(const TestItem& other) const
+    {
+        return
+            name == other.name &&
+            count == other.count &&
+            weight == other.weight &&
+            tags == other.tags;
+    }
+};
+
+// *table: test3
+struct Test3
+{
+    // *pk: true
+    // *autoincrement: true
+    int id;
+
+    short s; // SMALLINT
+    signed char t; // TINYINT
+    float r; // REAL
+
+    // *dataType: Char
+    // *length: 2
+    std::string code;
+
+    // *dataType: Date
+    std::string date;
+
+    // *dataType: Timestamp
+    std::string timestamp;
+
+    // *dataType: Decimal
+    // *precision: 10
+    // *scale: 2
+    std::string price;
+
+    // *lazy: true
+    std::vector<char> blob;
+
+    // *json: true
+    std::list<TestItem> items;
+
+    // native arrays on PostgreSQL
+    // *gin: true
+    std::vector<int> groups;
+    std::vector<std::string> labels;
+};
+
 
 } // namespace test
 } // namespace ngrest
@@ -6,15 +6,18 @@
 ##var lastNsEnd
 \
 #include <ngrest/db/Field.h>
+#include <ngrest/db/Index.h>
 #include <ngrest/db/Db.h>
 #include <ngrest/db/Query.h>
 #include <ngrest/db/QueryImpl.h>
+#include <ngrest/db/JsonColumn.h>
 
 #include "$(interface.name)Entities.h"
 \
 \
 ##foreach $(.structs)
 ##ifeq($(.isExtern),false)
+##ifneq($(.options.*json),true)
 ##include <common/nsopt.cpp>
 
 // $(.name)
@@ -61,6 +64,24 @@ $(.name)\
     return fieldsNames;
 }
 
+const std::string& $(.name)Entity::getSelectFieldsNamesStr() const
+{
+    const static std::string fieldsNames = "\
+##var first 1
+##foreach $(.fields)
+##ifneq($(.options.*lazy),true)
+##ifeq($($first),1)
+##var first 0
+##else
+,\
+##endif
+$(.name)\
+##endif
+##endfor
+";
+    return fieldsNames;
+}
+
 const std::string& $(.name)Entity::getFieldsArgs() const
 {
     const static std::string fieldsNames = "(\
@@ -90,27 +111,57 @@ const std::list< ::ngrest::Field>& $(.name)Entity::getFields() const
 ##var type $(.dataType.type)
 ##var name $(.dataType.name)
 ##endif
-##switch $($type)
-##case string
-String\
-##case enum
-Enum\
-##case generic
-##ifeq($($name.!match/bool/),true)
-Bool\
-##else
-##ifeq($($name.!match/float/),true)
-Float\
+##var kind $($type)-$($name)
+##ifeq($($type),template)
+##ifeq($(.dataType.name),Nullable)
+##var kind $($type)-$($name)-$(.dataType.templateParams.templateParam1.templateParams.templateParam1)
 ##else
-##ifeq($($name.!match/double/),true)
+##var kind $($type)-$($name)-$(.dataType.templateParams.templateParam1)
+##endif
+##endif
+##ifneq($(.options.*dataType),)
+##var kind dataType
+##endif
+##ifeq($(.options.*json),true)
+##var kind json
+##endif
+##switch $($kind)
+##case json
+Json\
+##case dataType
+$(.options.dataType)\
+##case generic-bool
+Bool\
+##case generic-float
+Real\
+##case generic-double
 Float\
-##else // defaulting to int
-Int  /* defaulted to int from $(.dataType) */ \
-##endif // double/int
-##endif // float
-##endif // bool
+##case generic-char||generic-signed char||generic-int8_t
+TinyInt\
+##case generic-short||generic-unsigned char||generic-int16_t||generic-uint8_t
+SmallInt\
+##case generic-long||generic-long long||generic-unsigned||generic-unsigned int||generic-unsigned long||generic-unsigned long long||generic-int64_t||generic-uint32_t||generic-uint64_t
+BigInt\
+##case template-vector-char||template-std::vector-char
+Blob\
+##case template-vector-int||template-std::vector-int
+IntArray\
+##case template-vector-std::string||template-std::vector-std::string
+StringArray\
 ##default
+##ifeq($($type),generic)
+Int  /* defaulted to int from $(.dataType) */ \
+##else
+##ifeq($($type),string)
+String\
+##else
+##ifeq($($type),enum)
+Enum\
+##else
 ##error Cannot serialize type #1: $(.dataType)
+##endif
+##endif
+##endif
 ##endswitch
 , // type
             "$(.options.*type)", // DBMS type
@@ -147,24 +198,88 @@ Int  /* defaulted to int from $(.dataType) */ \
                 "$($fkField)",
                 "$(.options.*onDelete||interface.*defaultOnDelete)",
                 "$(.options.*onUpdate||interface.*defaultOnUpdate)"
-            }
+            },
 
 ##else
-            nullptr // foreignKey
+            nullptr, // foreignKey
 ##endif // fk
+            $(.options.*length||"0"), // length
+            $(.options.*precision||"0"), // precision
+            $(.options.*scale||"0"), // scale
+            $(.options.*lazy||"false") // lazy
         },
 ##endfor
     };
     return fields;
 }
 
+const std::list< ::ngrest::Index>& $(.name)Entity::getIndexes() const
+{
+    // fields with "*index: true" or "*gin: true" and the declarations from struct's "*index" separated by ';'
+    // raw string, so quoted identifiers in a WHERE clause need no escaping
+    const static std::list< ::ngrest::Index> indexes = ::ngrest::Index::parseList(R"ngrest(\
+##foreach $(.fields)
+##ifeq($(.options.*index),true)
+$(struct.options.*table)_$(.name)_idx($(.name));\
+##endif
+##ifeq($(.options.*gin),true)
+$(struct.options.*table)_$(.name)_gin($(.name)) using gin;\
+##endif
+##endfor
+$(.options.*index))ngrest");
+    return indexes;
+}
+
+const ::ngrest::TableOptions& $(.name)Entity::getTableOptions() const
+{
+    const static ::ngrest::TableOptions options = {
+        $(.options.*unlogged||"false"), // unlogged
+        $(.options.*withoutRowid||"false"), // without rowid
+        "$(.options.*engine)", // engine
+        "$(.options.*rowFormat)", // row format
+        $(.options.*fillfactor||"0") // fill factor
+    };
+    return options;
+}
+
+##endif // json
 ##endif
 ##endfor
 $($lastNsEnd)
 
 namespace ngrest {
 ##foreach $(.structs)
+##ifeq($(.isExtern)-$(.options.*json),false-true)
+
+void writeJson(JsonColumnWriter& writer, const $(struct.nsName)& data)
+{
+    writer.beginObject();
+##foreach $(.fields)
+    writer.key("$(.name)");
+    writeJson(writer, data.$(.name));
+##endfor
+    writer.endObject();
+}
+
+void readJson(JsonColumnReader& reader, $(struct.nsName)& data)
+{
+    std::string key;
+    reader.beginObject();
+    while (reader.nextKey(key)) {
+##foreach $(.fields)
+        if (key == "$(.name)") {
+            readJson(reader, data.$(.name));
+            continue;
+        }
+##endfor
+        reader.skipValue(); // unknown member
+    }
+}
+##endif
+##endfor
+##foreach $(.structs)
 ##ifeq($(.isExtern),false)
+##ifneq($(.options.*json),true)
 
 template <>
 const Entity& getEntityByDataType< $(.nsName) >()
@@ -182,6 +297,9 @@ void bindDataToQuery(Query& query, const $(struct.nsName)& data)
 ##else
 ##var type $(.dataType.type)
 ##endif
+##ifeq($(.options.*json),true)
+    query.bindJson($($index), data.$(.name));
+##else
 ##switch $($type)
 ##case enum
 ##ifeq($(.dataType.type)-$(.dataType.name),template-Nullable)
@@ -193,11 +311,25 @@ void bindDataToQuery(Query& query, const $(struct.nsName)& data)
 ##else
     query.bind($($index), static_cast<int>(data.$(.name)));
 ##endif
-##case generic||string
+##case string
+    query.bindBorrowed($($index), data.$(.name));
+##case template
+##ifeq($(.dataType.name),Nullable)
+##var item $(.dataType.templateParams.templateParam1.templateParams.templateParam1)
+##else
+##var item $(.dataType.templateParams.templateParam1)
+##endif
+##ifeq($($item),char) // blob is bound without copying
+    query.bindBorrowed($($index), data.$(.name));
+##else
+    query.bind($($index), data.$(.name));
+##endif
+##case generic
     query.bind($($index), data.$(.name));
 ##default
 ##error Cannot serialize type #2: $(.dataType)
 ##endswitch
+##endif // json
 \
 ##var index $($index.!inc)
 \
@@ -220,6 +352,9 @@ void bindDataToQuery(Query& query, const $(struct.nsName)& data, const std::bits
 ##else
 ##var type $(.dataType.type)
 ##endif
+##ifeq($(.options.*json),true)
+        query.bindJson(index++, data.$(.name));
+##else
 ##switch $($type)
 ##case enum
 ##ifeq($(.dataType.type)-$(.dataType.name),template-Nullable)
@@ -231,11 +366,25 @@ void bindDataToQuery(Query& query, const $(struct.nsName)& data, const std::bits
 ##else
         query.bind(index++, static_cast<int>(data.$(.name)));
 ##endif
-##case generic||string
+##case string
+        query.bindBorrowed(index++, data.$(.name));
+##case template
+##ifeq($(.dataType.name),Nullable)
+##var item $(.dataType.templateParams.templateParam1.templateParams.templateParam1)
+##else
+##var item $(.dataType.templateParams.templateParam1)
+##endif
+##ifeq($($item),char) // blob is bound without copying
+        query.bindBorrowed(index++, data.$(.name));
+##else
+        query.bind(index++, data.$(.name));
+##endif
+##case generic
         query.bind(index++, data.$(.name));
 ##default
 ##error Cannot serialize type #3: $(.dataType)
 ##endswitch
+##endif // json
 \
 ##var index $($index.!inc)
 \
@@ -243,35 +392,39 @@ void bindDataToQuery(Query& query, const $(struct.nsName)& data, const std::bits
 ##endfor
 }
 
-void readDataFromQuery(Query& query, $(struct.nsName)& data)
+int readDataFromQuery(Query& query, $(struct.nsName)& data, int column)
 {
-##var index 0
 ##foreach $(.fields)
+##ifneq($(.options.*lazy),true)
 ##ifeq($(.dataType.type)-$(.dataType.name),template-Nullable)
 ##var type $(.dataType.templateParams.templateParam1.type)
 ##else
 ##var type $(.dataType.type)
 ##endif
+##ifeq($(.options.*json),true)
+    query.resultJson(column++, data.$(.name));
+##else
 ##switch $($type)
 ##case enum
 ##ifeq($(.dataType.type)-$(.dataType.name),template-Nullable)
-    if (query.resultIsNull($($index))) {
+    if (query.resultIsNull(column)) {
         data.$(.name).setNull();
+        ++column;
     } else {
-        data.$(.name).get() = static_cast< $(.dataType.templateParams.templateParam1) >(query.resultInt($($index)));
+        data.$(.name).get() = static_cast< $(.dataType.templateParams.templateParam1) >(query.resultInt(column++));
     }
 ##else
-    data.$(.name) = static_cast< $(.dataType) >(query.resultInt($($index)));
+    data.$(.name) = static_cast< $(.dataType) >(query.resultInt(column++));
 ##endif
-##case generic||string
-    query.result($($index), data.$(.name));
+##case generic||string||template
+    query.result(column++, data.$(.name));
 ##default
 ##error Cannot serialize type #4: $(.dataType)
 ##endswitch
-\
-##var index $($index.!inc)
-\
+##endif // json
+##endif // lazy
 ##endfor
+    return column;
 }
 
 void readDataFromQuery(Query& query, $(struct.nsName)& data, const std::bitset<$($fieldsCount)>& includedFields)
@@ -285,6 +438,9 @@ void readDataFromQuery(Query& query, $(struct.nsName)& data, const std::bitset<$
 ##else
 ##var type $(.dataType.type)
 ##endif
+##ifeq($(.options.*json),true)
+        query.resultJson(index++, data.$(.name));
+##else
 ##switch $($type)
 ##case enum
 ##ifeq($(.dataType.type)-$(.dataType.name),template-Nullable)
@@ -297,11 +453,12 @@ void readDataFromQuery(Query& query, $(struct.nsName)& data, const std::bitset<$
 ##else
         data.$(.name) = static_cast< $(.dataType) >(query.resultInt(index++));
 ##endif
-##case generic||string
+##case generic||string||template
         query.result(index++, data.$(.name));
 ##default
 ##error Cannot serialize type #5: $(.dataType)
 ##endswitch
+##endif // json
 \
 ##var index $($index.!inc)
 \
@@ -310,6 +467,7 @@ void readDataFromQuery(Query& query, $(struct.nsName)& data, const std::bitset<$
 }
 
 
+##endif // json
 ##endif
 ##endfor
 
@@ -319,21 +477,43 @@ void readDataFromQuery(Query& query, $(struct.nsName)& data, const std::bitset<$
 // debug operator helpers
 ##foreach $(.structs)
 ##ifeq($(struct.isExtern),false)
+##ifneq($(struct.options.*json),true)
 std::ostream& operator<<(std::ostream& out, const $(struct.nsName)& data)
 {
 ##foreach $(struct.fields)
+##ifeq($(.options.*json),true)
+    out << "\t" << ::ngrest::toJsonColumn(data.$(field.name));
+##else
 ##ifeq($(.dataType.type)-$(.dataType.name),template-Nullable)
     if ((data.$(field.name).isNull())) {
         out << "\tnull";
     } else {
+##ifeq($(.dataType.templateParams.templateParam1.type),template)
+##ifeq($(.dataType.templateParams.templateParam1.templateParams.templateParam1),char)
+        out << "\t[" << (*data.$(field.name)).size() << " bytes]";
+##else
+        out << "\t" << ::ngrest::toJsonColumn(*data.$(field.name));
+##endif
+##else
         out << "\t" << *data.$(field.name);
+##endif
     }
+##else
+##ifeq($(.dataType.type),template)
+##ifeq($(.dataType.templateParams.templateParam1),char)
+    out << "\t[" << data.$(field.name).size() << " bytes]";
+##else
+    out << "\t" << ::ngrest::toJsonColumn(data.$(field.name));
+##endif
 ##else
     out << "\t" << data.$(field.name);
 ##endif
+##endif
+##endif // json
 ##endfor
     return out;
 }
 
+##endif // json
 ##endif
 ##endfor
@@ -19,6 +19,7 @@
 
 ##foreach $(.structs)
 ##ifeq($(struct.isExtern),false)
+##ifneq($(struct.options.*json),true)
 ##include <common/nsopt.cpp>
 class $(struct.name)Entity: public ::ngrest::Entity
 {
@@ -28,10 +29,14 @@ public:
     const std::string& getTableName() const override;
     const std::list<std::string>& getFieldsNames() const override;
     const std::string& getFieldsNamesStr() const override;
+    const std::string& getSelectFieldsNamesStr() const override;
     const std::string& getFieldsArgs() const override;
     const std::list< ::ngrest::Field>& getFields() const override;
+    const std::list< ::ngrest::Index>& getIndexes() const override;
+    const ::ngrest::TableOptions& getTableOptions() const override;
 };
 
+##endif // json
 ##endif
 ##endfor
 
@@ -40,9 +45,22 @@ $($lastNsEnd)
 namespace ngrest {
 
 class Query;
+class JsonColumnWriter;
+class JsonColumnReader;
 
 ##foreach $(.structs)
 ##ifeq($(struct.isExtern),false)
+##ifeq($(struct.options.*json),true)
+//! serialize and parse the structure stored in JSON field
+void writeJson(JsonColumnWriter& writer, const $(struct.nsName)& data);
+void readJson(JsonColumnReader& reader, $(struct.nsName)& data);
+
+##endif
+##endif
+##endfor
+##foreach $(.structs)
+##ifeq($(struct.isExtern),false)
+##ifneq($(struct.options.*json),true)
 template <>
 const Entity& getEntityByDataType< $(struct.nsName) >();
 
@@ -56,12 +74,35 @@ constexpr unsigned long getEntityFieldsCount< $(struct.nsName) >()
     return $($fieldsCount);
 }
 
+##var pkFound 0
+##foreach $(struct.fields)
+##ifeq($(.options.*pk),true)
+##ifeq($($pkFound),0)
+##var pkFound 1
+template <>
+struct PrimaryKey< $(struct.nsName) >
+{
+    typedef $(.dataType) Type;
+
+    static const Type& get(const $(struct.nsName)& data)
+    {
+        return data.$(.name);
+    }
+};
+
+##endif
+##endif
+##endfor
+
 void bindDataToQuery(Query& query, const $(struct.nsName)& data);
 void bindDataToQuery(Query& query, const $(struct.nsName)& data, const std::bitset<$($fieldsCount)>& includedFields);
-void readDataFromQuery(Query& query, $(struct.nsName)& data);
+//! read all the fields except lazy ones starting from the column
+//! returns the column next to the last read
+int readDataFromQuery(Query& query, $(struct.nsName)& data, int column = 0);
 void readDataFromQuery(Query& query, $(struct.nsName)& data, const std::bitset<$($fieldsCount)>& includedFields);
 
 
+##endif // json
 ##endif
 ##endfor
 } // namespace ngrest
@@ -70,7 +111,9 @@ void readDataFromQuery(Query& query, $(struct.nsName)& data, const std::bitset<$
 // debug operator helpers
 ##foreach $(.structs)
 ##ifeq($(struct.isExtern),false)
+##ifneq($(struct.options.*json),true)
 std::ostream& operator<<(std::ostream& out, const $(struct.nsName)& data);
+##endif // json
 ##endif
 ##endfor
 
@@ -12,6 +12,7 @@ namespace ngrest {
 ##foreach $(project.interfaces)
 ##foreach $(.structs)
 ##ifeq($(struct.isExtern),false)
+##ifneq($(struct.options.*json),true)
 
 template <>
 constexpr unsigned long getEntityIndex< $(struct.nsName) >()
@@ -26,6 +27,7 @@ struct DataTypeWrapper<$($entityIndex)>
 };
 
 ##var entityIndex $($entityIndex.!inc)
+##endif // json
 ##endif
 ##endfor
 ##endfor